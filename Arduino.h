@@ -23,13 +23,99 @@ extern "C"
 /////////
 #define OUTPUT 0x01
 #define INPUT  0x00
+#define INPUT_PULLUP 0x02
 
 #define HIGH 0x01
 #define LOW  0x00
 
+#define LSBFIRST 0
+#define MSBFIRST 1
+
 void pinMode( uint8_t pin, uint8_t mode );
 void digitalWrite( uint8_t pin, uint8_t val );
 int digitalRead( uint8_t pin );
+int analogRead( uint8_t pin );
+void shiftOut( uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val );
+
+/////////
+// PORTS
+/////////
+// The AVR core provides these as macros for reading or writing a whole
+// port of pins at once. They are declared as functions here, and the
+// self-referencing defines let code test for them with #ifdef just as on
+// the AVR core.
+#define NOT_A_PORT 0
+
+uint8_t digitalPinToPort( uint8_t pin );
+uint8_t digitalPinToBitMask( uint8_t pin );
+volatile uint8_t* portInputRegister( uint8_t port );
+volatile uint8_t* portOutputRegister( uint8_t port );
+
+#define digitalPinToPort digitalPinToPort
+#define digitalPinToBitMask digitalPinToBitMask
+
+// Tests define SAMDUINO_NO_PORT_REGISTERS to build code as it is on cores
+// without the port registers.
+#ifndef SAMDUINO_NO_PORT_REGISTERS
+#define portInputRegister portInputRegister
+#define portOutputRegister portOutputRegister
+#endif
+
+/////////
+// EEPROM
+/////////
+// As in avr-libc's <avr/eeprom.h>, addresses are given as pointers into
+// the EEPROM address space. A write returns once it has started; the
+// next access blocks until it completes unless eeprom_is_ready().
+#ifndef E2END
+#define E2END 0x3FF
+#endif
+
+uint8_t eeprom_read_byte( const uint8_t* address );
+void eeprom_write_byte( uint8_t* address, uint8_t value );
+int eeprom_is_ready( void );
+
+/////////
+// TIMER
+/////////
+// The arduino core has no API for timer interrupts. On AVR these are
+// provided by samduino's HardwareTimer.cpp using Timer1. Only one timer
+// interrupt may be attached at a time, and attaching returns false if
+// no timer is available. As with the ports, the defines let code test
+// for them with #ifdef.
+bool attachTimerInterrupt( unsigned long periodMicros, void (*isr)( void ) );
+void detachTimerInterrupt( void );
+
+#define attachTimerInterrupt attachTimerInterrupt
+#define detachTimerInterrupt detachTimerInterrupt
+
+/////////
+// INTERRUPTS
+/////////
+// The AVR core defines these as macros for cli() and sei().
+void noInterrupts( void );
+void interrupts( void );
+
+// avr-libc's macros for the instructions which clear and set the global
+// interrupt flag, SREG_I (see SREG below).
+void cli( void );
+void sei( void );
+
+#define SREG_I 7
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define NOT_AN_INTERRUPT -1
+
+// On the Uno only pins 2 and 3 have an interrupt, and this is a macro
+// mapping them to 0 and 1. In testing every pin is its own interrupt.
+int digitalPinToInterrupt( uint8_t pin );
+void attachInterrupt( uint8_t interruptNum, void (*isr)( void ), int mode );
+void detachInterrupt( uint8_t interruptNum );
+
+#define digitalPinToInterrupt digitalPinToInterrupt
 
 /////////
 // TIME
@@ -41,6 +127,18 @@ unsigned long micros();
 
 #ifdef __cplusplus
 } // extern "C"
+
+// SREG stands in for the AVR status register, of which only SREG_I is
+// kept. Code that must not turn interrupts back on for its caller, or
+// inside an interrupt, saves SREG, calls cli() and then restores SREG
+// instead of calling noInterrupts() and interrupts().
+struct ArduinoStatusRegister
+{
+    operator uint8_t() const;
+    ArduinoStatusRegister& operator=( uint8_t );
+};
+
+extern ArduinoStatusRegister SREG;
 #endif
 
 #endif
@@ -0,0 +1,69 @@
+#ifndef ArduinoSPI_h
+#define ArduinoSPI_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Arduino.h"
+
+/**
+ * This file replicates the declarations of the arduino SPI library
+ * needed by the samduino library. As with Arduino.h, they are
+ * implemented in testing to verify the library.
+ *
+ * Chip select is not part of the bus; it is driven with digitalWrite().
+ */
+
+// see: https://www.arduino.cc/reference/en/language/functions/communication/spi/
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+#ifdef __cplusplus
+
+class SPISettings
+{
+public:
+    SPISettings( uint32_t clock, uint8_t bitOrder, uint8_t dataMode )
+        : clock( clock )
+        , bitOrder( bitOrder )
+        , dataMode( dataMode )
+    {}
+
+    SPISettings()
+        : clock( 4000000 )
+        , bitOrder( MSBFIRST )
+        , dataMode( SPI_MODE0 )
+    {}
+
+    uint32_t clock;
+    uint8_t bitOrder;
+    uint8_t dataMode;
+};
+
+class SPIClass
+{
+public:
+    static void begin();
+    static void end();
+
+    // A transaction claims the bus with the given settings until
+    // endTransaction(). Any number of transfers may be batched inside.
+    static void beginTransaction( SPISettings settings );
+    static void endTransaction();
+
+    static uint8_t transfer( uint8_t data );
+    static uint16_t transfer16( uint16_t data );
+
+    // The buffered transfer sends `count` bytes from `buf` and replaces
+    // them with the bytes received.
+    static void transfer( void* buf, size_t count );
+};
+
+extern SPIClass SPI;
+
+#endif // c++
+
+#endif
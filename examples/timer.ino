@@ -2,7 +2,7 @@
 
 /**
  * Read the clock via `millis()` and sets the
- * whole-seconds value on a 4-digit 7-segment LED.
+ * elapsed seconds, to the tenth, on a 4-digit 7-segment LED.
  */
 
 namespace
@@ -12,13 +12,15 @@ namespace
 struct MyLayout
 {
   uint8_t dPins[4];
-  uint8_t dBits[4];
+  uint8_t dBits[2][4];
+  samduino::SevenSegmentFrame frame;
   samduino::SevenSegmentState layout;
 
   MyLayout()
+    : frame( dBits[0], dBits[1] )
   {
     layout.NumD = 4;
-    layout.DBits = dBits;
+    layout.Frame = &frame;
     layout.DPins = dPins;
 
     dPins[0] = 5;
@@ -37,33 +39,59 @@ struct MyLayout
   }
 };
 
-// A ScheduledWork that reads the system clock and
-// sets the digits in the display.
+// A ScheduledWork that reads the system clock and publishes the
+// elapsed tenths of a second. It runs again right when the next tenth
+// starts rather than polling for it.
 class ClockWork : public samduino::ScheduledWork
 {
 public:
-  explicit ClockWork( samduino::SevenSegmentState& layout )
-    : m_layout( layout )
-    , m_nextDueAt( 0 )
+  explicit ClockWork( samduino::Observable< unsigned long >& tenths )
+    : m_tenths( tenths )
   {}
 
-  unsigned long DueAtMillis() override { return m_nextDueAt; }
+  unsigned long DoWork( unsigned long now ) override
+  {
+    m_tenths.Publish( now / 100 );
+    return ( now / 100 + 1 ) * 100;
+  }
+
+private:
+  samduino::Observable< unsigned long >& m_tenths;
+};
+
+// A ScheduledWork that sets the digits in the display, only when
+// the tenths change.
+class RenderWork : public samduino::ScheduledWork
+{
+public:
+  RenderWork( samduino::SevenSegment& seven, samduino::Observable< unsigned long >& tenths )
+    : m_seven( seven )
+    , m_tenths( tenths )
+  {}
 
-  void DoWork() override
+  unsigned long DoWork( unsigned long now ) override
   {
-    unsigned long now = millis();
-    m_nextDueAt = now + 100;
-
-    // Display as like 100.7 (seconds) when 1007xx milliseconds have elapsed.
-    m_layout.DBits[0] = samduino::SevenSegment::MakeBits( static_cast< uint8_t >( ( now / 100000 ) % 10 ) );
-    m_layout.DBits[1] = samduino::SevenSegment::MakeBits( static_cast< uint8_t >( ( now / 10000 ) % 10 ) );
-    m_layout.DBits[2] = samduino::SevenSegment::MakeBits( static_cast< uint8_t >( ( now / 1000 ) % 10 ), samduino::Dotted::kWithDot );
-    m_layout.DBits[3] = samduino::SevenSegment::MakeBits( static_cast< uint8_t >( ( now / 100 ) % 10 ) );
+    // The display is still picking up our last frame; try again soon.
+    uint8_t* dBits = m_seven.Compose();
+    if ( !dBits )
+    {
+      return now + 1;
+    }
+
+    // Display as like 100.7 (seconds) when 1007 tenths have elapsed.
+    const unsigned long tenths = m_tenths.Get();
+    dBits[0] = samduino::SevenSegment::MakeBits( static_cast< uint8_t >( ( tenths / 1000 ) % 10 ) );
+    dBits[1] = samduino::SevenSegment::MakeBits( static_cast< uint8_t >( ( tenths / 100 ) % 10 ) );
+    dBits[2] = samduino::SevenSegment::MakeBits( static_cast< uint8_t >( ( tenths / 10 ) % 10 ), samduino::Dotted::kWithDot );
+    dBits[3] = samduino::SevenSegment::MakeBits( static_cast< uint8_t >( tenths % 10 ) );
+    m_seven.Publish();
+
+    return SCHEDULER_NEVER;
   }
 
 private:
-  samduino::SevenSegmentState& m_layout;
-  unsigned long m_nextDueAt;
+  samduino::SevenSegment& m_seven;
+  samduino::Observable< unsigned long >& m_tenths;
 };
 
 // My globals initialized in setup()
@@ -72,6 +100,8 @@ samduino::SevenSegment* gSeven;
 samduino::Scheduler* gScheduler;
 samduino::ScheduledWork* gDisplayWork;
 samduino::ScheduledWork* gClockWork;
+samduino::ScheduledWork* gRenderWork;
+samduino::Observable< unsigned long >* gTenths;
 
 }
 
@@ -83,13 +113,17 @@ void setup() {
   gScheduler = new samduino::Scheduler( config );
 
   gDisplayWork = new samduino::SevenSegmentDisplayWork( *gSeven );
-  gClockWork = new ClockWork( gLayout->layout );
+  gTenths = new samduino::Observable< unsigned long >( *gScheduler );
+  gClockWork = new ClockWork( *gTenths );
+  gRenderWork = new RenderWork( *gSeven, *gTenths );
+  gTenths->AddDependent( *gRenderWork );
 
   // Keep the display refreshed as scheduled work
   gScheduler->AddWork( *gDisplayWork );
 
-  // Also read the clock regularly and update our state.
+  // Also read the clock regularly, and redraw whenever it changes.
   gScheduler->AddWork( *gClockWork );
+  gScheduler->AddWork( *gRenderWork );
 }
 
 void loop() {
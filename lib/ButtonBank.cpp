@@ -0,0 +1,244 @@
+#include "ButtonBank.h"
+#include "Arduino.h"
+
+namespace samduino
+{
+
+namespace
+{
+
+// No bank bit can be this since there are at most 32.
+const uint8_t kNoBit = 0xFF;
+
+#ifdef portInputRegister
+uint8_t MaskToBit( uint8_t mask )
+{
+    uint8_t bit = 0;
+    while ( mask > 1 )
+    {
+        mask >>= 1;
+        bit++;
+    }
+
+    return bit;
+}
+#endif
+
+}
+
+ButtonBank::ButtonBank( const ButtonBankConfig& config )
+    : m_config( config )
+    , m_used( 0 )
+    , m_readBits( 0 )
+#ifdef portInputRegister
+    , m_numPorts( 0 )
+#endif
+    , m_pressed( 0 )
+    , m_count0( 0xFFFFFFFFUL )
+    , m_count1( 0xFFFFFFFFUL )
+    , m_longPending( 0 )
+    , m_head( 0 )
+    , m_tail( 0 )
+    , m_overflows( 0 )
+{
+    for ( uint8_t i = 0; i < BUTTON_BANK_MAX_PINS; i++ )
+    {
+        m_pinToBit[i] = kNoBit;
+        m_bitToPin[i] = 0;
+        m_pressedAt[i] = 0;
+    }
+
+    const uint8_t numPins = m_config.NumPins < BUTTON_BANK_MAX_PINS
+        ? m_config.NumPins
+        : BUTTON_BANK_MAX_PINS;
+
+    for ( uint8_t i = 0; i < numPins; i++ )
+    {
+        const uint8_t pin = m_config.Pins[i];
+        pinMode( pin, m_config.ActiveLow ? INPUT_PULLUP : INPUT );
+
+#ifdef portInputRegister
+        // Find (or claim) the slot for this pin's port. Pins without a
+        // port, or beyond the ports we can track, are read below.
+        const uint8_t port = digitalPinToPort( pin );
+        if ( port == NOT_A_PORT )
+        {
+            continue;
+        }
+
+        volatile uint8_t* reg = portInputRegister( port );
+        uint8_t slot = 0;
+        while ( slot < m_numPorts && m_ports[slot] != reg )
+        {
+            slot++;
+        }
+
+        if ( slot == m_numPorts )
+        {
+            if ( m_numPorts == BUTTON_BANK_MAX_PORTS )
+            {
+                continue;
+            }
+
+            m_ports[m_numPorts++] = reg;
+        }
+
+        const uint8_t bit = slot * 8 + MaskToBit( digitalPinToBitMask( pin ) );
+        m_pinToBit[i] = bit;
+        m_bitToPin[bit] = pin;
+        m_used |= 1UL << bit;
+#endif
+    }
+
+    // The rest of the pins are read with digitalRead() into whichever
+    // bits are left over. There is always one, as there are at most 32
+    // pins.
+    uint8_t bit = 0;
+    for ( uint8_t i = 0; i < numPins; i++ )
+    {
+        if ( m_pinToBit[i] != kNoBit )
+        {
+            continue;
+        }
+
+        while ( ( m_used >> bit ) & 1 )
+        {
+            bit++;
+        }
+
+        m_pinToBit[i] = bit;
+        m_bitToPin[bit] = m_config.Pins[i];
+        m_used |= 1UL << bit;
+        m_readBits |= 1UL << bit;
+    }
+}
+
+uint32_t ButtonBank::Sample()
+{
+    uint32_t raw = 0;
+
+#ifdef portInputRegister
+    for ( uint8_t i = 0; i < m_numPorts; i++ )
+    {
+        raw |= static_cast< uint32_t >( *m_ports[i] ) << ( 8 * i );
+    }
+
+    // Those bits of the ports belong to other pins
+    raw &= ~m_readBits;
+#endif
+
+    uint8_t bit = 0;
+    for ( uint32_t bits = m_readBits; bits; bit++, bits >>= 1 )
+    {
+        if ( ( bits & 1 ) && digitalRead( m_bitToPin[bit] ) )
+        {
+            raw |= 1UL << bit;
+        }
+    }
+
+    if ( m_config.ActiveLow )
+    {
+        raw = ~raw;
+    }
+
+    return raw & m_used;
+}
+
+unsigned long ButtonBank::DoWork( unsigned long now )
+{
+    const uint32_t sample = Sample();
+
+    // Vertical 2-bit counters: a bit of the debounced state only flips
+    // after the sample disagrees with it 4 times in a row.
+    uint32_t changed = m_pressed ^ sample;
+    m_count0 = ~( m_count0 & changed );
+    m_count1 = m_count0 ^ ( m_count1 & changed );
+    changed &= m_count0 & m_count1;
+    m_pressed ^= changed;
+
+    if ( changed )
+    {
+        const uint32_t pressed = changed & m_pressed;
+        const uint32_t released = changed & ~m_pressed;
+
+        Emit( pressed, ButtonEventType::kPressed );
+        Emit( released, ButtonEventType::kReleased );
+
+        for ( uint8_t bit = 0; bit < BUTTON_BANK_MAX_PINS; bit++ )
+        {
+            if ( ( pressed >> bit ) & 1 )
+            {
+                m_pressedAt[bit] = now;
+            }
+        }
+
+        m_longPending = ( m_longPending | pressed ) & m_pressed;
+    }
+
+    if ( m_longPending && m_config.LongPressMs )
+    {
+        uint32_t held = 0;
+        for ( uint8_t bit = 0; bit < BUTTON_BANK_MAX_PINS; bit++ )
+        {
+            if ( ( ( m_longPending >> bit ) & 1 ) &&
+                 now - m_pressedAt[bit] >= m_config.LongPressMs )
+            {
+                held |= 1UL << bit;
+            }
+        }
+
+        Emit( held, ButtonEventType::kLongPress );
+        m_longPending &= ~held;
+    }
+
+    return now + m_config.SampleMs;
+}
+
+void ButtonBank::Emit( uint32_t bits, ButtonEventType type )
+{
+    for ( uint8_t bit = 0; bits; bit++, bits >>= 1 )
+    {
+        if ( !( bits & 1 ) )
+        {
+            continue;
+        }
+
+        if ( static_cast< uint8_t >( m_head - m_tail ) == BUTTON_BANK_QUEUE_SIZE )
+        {
+            m_overflows++;
+            continue;
+        }
+
+        ButtonEvent& event = m_events[m_head % BUTTON_BANK_QUEUE_SIZE];
+        event.Pin = m_bitToPin[bit];
+        event.Type = type;
+        m_head++;
+    }
+}
+
+bool ButtonBank::PopEvent( ButtonEvent& event )
+{
+    if ( m_head == m_tail )
+    {
+        return false;
+    }
+
+    event = m_events[m_tail % BUTTON_BANK_QUEUE_SIZE];
+    m_tail++;
+    return true;
+}
+
+bool ButtonBank::IsPressed( uint8_t pin ) const
+{
+    for ( uint8_t i = 0; i < m_config.NumPins && i < BUTTON_BANK_MAX_PINS; i++ )
+    {
+        if ( m_config.Pins[i] == pin && m_pinToBit[i] != kNoBit )
+        {
+            return ( m_pressed >> m_pinToBit[i] ) & 1;
+        }
+    }
+
+    return false;
+}
+
+} // samduino
@@ -0,0 +1,137 @@
+#ifndef Samduino_ButtonBank_h
+#define Samduino_ButtonBank_h
+
+/**
+ * The ButtonBank reads a whole set of buttons and switches from a
+ * single ScheduledWork. All of the pins are debounced at once using
+ * vertical counters: bit N of each counter word belongs to button N, so
+ * one handful of bitwise operations debounces every button in the bank.
+ *
+ * Where the core provides portInputRegister() the pins are sampled a
+ * port at a time, so the cost of a tick does not depend on the number
+ * of pins. Otherwise, and for pins beyond BUTTON_BANK_MAX_PORTS ports,
+ * each pin is read with digitalRead().
+ *
+ * Changes are reported as ButtonEvents through a small queue to be
+ * drained by whoever cares about them.
+ */
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+#include "Arduino.h"
+#include "Scheduler.h"
+
+#define BUTTON_BANK_MAX_PINS 32
+#define BUTTON_BANK_MAX_PORTS 4
+#define BUTTON_BANK_QUEUE_SIZE 16
+
+namespace samduino
+{
+
+/**
+ * A configuration structure describing the pins of the bank.
+ * Pins and NumPins are required.
+ */
+struct ButtonBankConfig
+{
+    // A NumPins-sized array of the input pins
+    const uint8_t* Pins;
+    uint8_t NumPins;
+
+    // Set when a pressed button reads LOW. The pins then use the
+    // internal pull-ups.
+    uint8_t ActiveLow;
+
+    // How often to sample. A change must be seen on 4 samples in a row,
+    // so the debounce time is 4 * SampleMs.
+    unsigned long SampleMs;
+
+    // How long each button must be held before it reports kLongPress,
+    // whatever the other buttons do meanwhile. 0 disables long presses.
+    unsigned long LongPressMs;
+
+    ButtonBankConfig()
+        : Pins( 0 )
+        , NumPins( 0 )
+        , ActiveLow( 1 )
+        , SampleMs( 5 )
+        , LongPressMs( 1000 )
+    {}
+};
+
+enum class ButtonEventType : uint8_t
+{
+    kPressed = 0,
+    kReleased = 1,
+    kLongPress = 2
+};
+
+struct ButtonEvent
+{
+    uint8_t Pin;
+    ButtonEventType Type;
+};
+
+/**
+ * ButtonBank implements the ScheduledWork to sample and debounce all of the
+ * configured pins each tick.
+ */
+class ButtonBank : public ScheduledWork
+{
+public:
+    explicit ButtonBank( const ButtonBankConfig& );
+
+    unsigned long DoWork( unsigned long now ) override;
+
+    // PopEvent takes the oldest event off the queue. It returns false
+    // when there are none.
+    bool PopEvent( ButtonEvent& );
+
+    // IsPressed returns the debounced state of the pin.
+    bool IsPressed( uint8_t pin ) const;
+
+    // Overflows counts the events dropped because the queue was full.
+    uint16_t Overflows() const { return m_overflows; }
+
+private:
+    uint32_t Sample();
+    void Emit( uint32_t bits, ButtonEventType type );
+
+    const ButtonBankConfig m_config;
+
+    // The bank bit each pin maps to, and back.
+    uint8_t m_pinToBit[BUTTON_BANK_MAX_PINS];
+    uint8_t m_bitToPin[BUTTON_BANK_MAX_PINS];
+    uint32_t m_used;
+    // The bank bits read with digitalRead()
+    uint32_t m_readBits;
+
+#ifdef portInputRegister
+    // With port reads, bank bit (8 * i + n) is bit n of m_ports[i].
+    volatile uint8_t* m_ports[BUTTON_BANK_MAX_PORTS];
+    uint8_t m_numPorts;
+#endif
+
+    // The debounced pressed state and its vertical counters
+    uint32_t m_pressed;
+    uint32_t m_count0;
+    uint32_t m_count1;
+
+    // Pressed buttons which have not yet reported a long press, and when
+    // each bank bit was last pressed
+    uint32_t m_longPending;
+    unsigned long m_pressedAt[BUTTON_BANK_MAX_PINS];
+
+    ButtonEvent m_events[BUTTON_BANK_QUEUE_SIZE];
+    uint8_t m_head;
+    uint8_t m_tail;
+    uint16_t m_overflows;
+};
+
+} // samduino
+
+#endif // c++
+
+#endif
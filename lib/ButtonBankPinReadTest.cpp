@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include "ArduinoTestState.h"
+#include "ButtonBank.h"
+
+// This is built into a test of its own along with ButtonBank.cpp, both
+// without portInputRegister(), so each pin is read with digitalRead().
+#ifdef portInputRegister
+#error Build ButtonBankPinReadTest.cpp with SAMDUINO_NO_PORT_REGISTERS
+#endif
+
+using namespace samduino;
+
+TEST( ButtonBankPinReadTest, DebouncesWithDigitalRead )
+{
+    InMemoryInputOutputProvider io;
+    ArduinoTestState state;
+    state.SetInputOutputProvider( &io );
+
+    // Pins on different ports, out of order
+    const uint8_t pins[3] = { 14, 3, 9 };
+    ButtonBankConfig config;
+    config.Pins = pins;
+    config.NumPins = 3;
+    config.LongPressMs = 0;
+    ButtonBank bank( config );
+
+    auto set = [&]( uint8_t pin, bool pressed ) {
+        InMemoryInputOutputProvider::PinState pinState = io.ReadState( pin );
+        pinState.value = pressed ? LOW : HIGH;
+        io.WriteState( pinState );
+    };
+
+    unsigned long now = 0;
+    set( 14, false );
+    set( 3, false );
+    set( 9, true );
+    for ( uint8_t i = 0; i < 3; i++ )
+    {
+        now = bank.DoWork( now );
+    }
+    EXPECT_FALSE( bank.IsPressed( 9 ) );
+
+    now = bank.DoWork( now );
+    EXPECT_TRUE( bank.IsPressed( 9 ) );
+    EXPECT_FALSE( bank.IsPressed( 14 ) );
+    EXPECT_FALSE( bank.IsPressed( 3 ) );
+
+    ButtonEvent event;
+    ASSERT_TRUE( bank.PopEvent( event ) );
+    EXPECT_EQ( 9, event.Pin );
+    EXPECT_EQ( ButtonEventType::kPressed, event.Type );
+    EXPECT_FALSE( bank.PopEvent( event ) );
+
+    set( 9, false );
+    for ( uint8_t i = 0; i < 4; i++ )
+    {
+        now = bank.DoWork( now );
+    }
+    ASSERT_TRUE( bank.PopEvent( event ) );
+    EXPECT_EQ( 9, event.Pin );
+    EXPECT_EQ( ButtonEventType::kReleased, event.Type );
+}
@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+
+#include "ArduinoTestState.h"
+#include "ButtonBank.h"
+
+using namespace samduino;
+
+namespace
+{
+
+class ButtonBankTest : public ::testing::Test
+{
+public:
+    ButtonBankTest()
+        : m_now( 0 )
+    {
+        m_state.SetInputOutputProvider( &m_io );
+
+        // 16 buttons over all three ports of an Uno
+        for ( uint8_t i = 0; i < 16; i++ )
+        {
+            m_pins[i] = i + 2;
+        }
+
+        m_config.Pins = m_pins;
+        m_config.NumPins = 16;
+        m_config.SampleMs = 5;
+        m_config.LongPressMs = 500;
+    }
+
+protected:
+
+    // Set is pressed, which reads LOW with the default pull-ups.
+    void Set( uint8_t pin, bool pressed )
+    {
+        InMemoryInputOutputProvider::PinState state = m_io.ReadState( pin );
+        state.value = pressed ? LOW : HIGH;
+        m_io.WriteState( state );
+    }
+
+    void Tick( ButtonBank& bank, uint8_t times = 1 )
+    {
+        for ( uint8_t i = 0; i < times; i++ )
+        {
+            m_now = bank.DoWork( m_now );
+        }
+    }
+
+    InMemoryInputOutputProvider m_io;
+    ArduinoTestState m_state;
+    uint8_t m_pins[16];
+    ButtonBankConfig m_config;
+    unsigned long m_now;
+};
+
+}
+
+TEST_F( ButtonBankTest, DebouncesPressAndRelease )
+{
+    ButtonBank bank( m_config );
+    ButtonEvent event;
+
+    Tick( bank, 4 );
+    EXPECT_FALSE( bank.PopEvent( event ) );
+
+    // Bouncing never lasts long enough to register
+    for ( uint8_t i = 0; i < 10; i++ )
+    {
+        Set( 9, i % 2 == 0 );
+        Tick( bank );
+    }
+    EXPECT_FALSE( bank.PopEvent( event ) );
+    EXPECT_FALSE( bank.IsPressed( 9 ) );
+
+    // Once stable it takes 4 samples
+    Set( 9, true );
+    Tick( bank, 3 );
+    EXPECT_FALSE( bank.IsPressed( 9 ) );
+    Tick( bank );
+    EXPECT_TRUE( bank.IsPressed( 9 ) );
+
+    ASSERT_TRUE( bank.PopEvent( event ) );
+    EXPECT_EQ( 9, event.Pin );
+    EXPECT_EQ( ButtonEventType::kPressed, event.Type );
+    EXPECT_FALSE( bank.PopEvent( event ) );
+
+    Set( 9, false );
+    Tick( bank, 4 );
+    ASSERT_TRUE( bank.PopEvent( event ) );
+    EXPECT_EQ( 9, event.Pin );
+    EXPECT_EQ( ButtonEventType::kReleased, event.Type );
+}
+
+TEST_F( ButtonBankTest, ReportsSimultaneousChangesAcrossPorts )
+{
+    ButtonBank bank( m_config );
+    ButtonEvent event;
+
+    // One pin on each of PORTD, PORTB and PORTC
+    Set( 2, true );
+    Set( 8, true );
+    Set( 17, true );
+    Tick( bank, 4 );
+
+    uint8_t seen = 0;
+    while ( bank.PopEvent( event ) )
+    {
+        EXPECT_EQ( ButtonEventType::kPressed, event.Type );
+        EXPECT_TRUE( event.Pin == 2 || event.Pin == 8 || event.Pin == 17 );
+        seen++;
+    }
+    EXPECT_EQ( 3, seen );
+    EXPECT_TRUE( bank.IsPressed( 17 ) );
+    EXPECT_FALSE( bank.IsPressed( 16 ) );
+}
+
+TEST_F( ButtonBankTest, ReadsPinsWithoutAPortOneByOne )
+{
+    // Pin 20 has no port, so it is read into the spare bit 0 of the
+    // sample, which on PORTD is pin 0 idling HIGH.
+    const uint8_t pins[3] = { 2, 3, 20 };
+    m_config.Pins = pins;
+    m_config.NumPins = 3;
+    pinMode( 0, INPUT_PULLUP );
+    ButtonBank bank( m_config );
+    ButtonEvent event;
+
+    Set( 20, true );
+    Tick( bank, 4 );
+    EXPECT_TRUE( bank.IsPressed( 20 ) );
+    EXPECT_FALSE( bank.IsPressed( 2 ) );
+    ASSERT_TRUE( bank.PopEvent( event ) );
+    EXPECT_EQ( 20, event.Pin );
+    EXPECT_FALSE( bank.PopEvent( event ) );
+
+    Set( 20, false );
+    Set( 3, true );
+    Tick( bank, 4 );
+    EXPECT_FALSE( bank.IsPressed( 20 ) );
+    EXPECT_TRUE( bank.IsPressed( 3 ) );
+}
+
+TEST_F( ButtonBankTest, ReportsLongPressOnce )
+{
+    ButtonBank bank( m_config );
+    ButtonEvent event;
+
+    Set( 4, true );
+    Tick( bank, 4 );
+    ASSERT_TRUE( bank.PopEvent( event ) );
+    EXPECT_EQ( ButtonEventType::kPressed, event.Type );
+
+    // 500ms at 5ms per sample
+    Tick( bank, 99 );
+    EXPECT_FALSE( bank.PopEvent( event ) );
+    Tick( bank );
+    ASSERT_TRUE( bank.PopEvent( event ) );
+    EXPECT_EQ( 4, event.Pin );
+    EXPECT_EQ( ButtonEventType::kLongPress, event.Type );
+
+    Tick( bank, 200 );
+    EXPECT_FALSE( bank.PopEvent( event ) );
+}
+
+TEST_F( ButtonBankTest, TimesLongPressesPerButton )
+{
+    ButtonBank bank( m_config );
+    ButtonEvent event;
+
+    Set( 4, true );
+    Tick( bank, 4 );
+    Tick( bank, 50 );
+
+    // Another button coming and going doesn't restart the first's
+    Set( 5, true );
+    Tick( bank, 4 );
+    Set( 5, false );
+    Tick( bank, 4 );
+    while ( bank.PopEvent( event ) )
+    {
+        EXPECT_NE( ButtonEventType::kLongPress, event.Type );
+    }
+
+    Tick( bank, 41 );
+    EXPECT_FALSE( bank.PopEvent( event ) );
+    Tick( bank );
+    ASSERT_TRUE( bank.PopEvent( event ) );
+    EXPECT_EQ( 4, event.Pin );
+    EXPECT_EQ( ButtonEventType::kLongPress, event.Type );
+    EXPECT_FALSE( bank.PopEvent( event ) );
+}
+
+TEST_F( ButtonBankTest, CountsOverflows )
+{
+    ButtonBank bank( m_config );
+
+    for ( uint8_t i = 0; i < 16; i++ )
+    {
+        Set( m_pins[i], true );
+    }
+    Tick( bank, 4 );
+
+    for ( uint8_t i = 0; i < 16; i++ )
+    {
+        Set( m_pins[i], false );
+    }
+    Tick( bank, 4 );
+
+    // 32 events into a queue of 16
+    EXPECT_EQ( 16, bank.Overflows() );
+}
+
+TEST_F( ButtonBankTest, PullsUpActiveLowPins )
+{
+    {
+        ButtonBank bank( m_config );
+        EXPECT_EQ( INPUT_PULLUP, m_io.ReadState( m_pins[0] ).mode );
+        EXPECT_EQ( HIGH, m_io.ReadState( m_pins[0] ).value );
+    }
+
+    m_config.ActiveLow = 0;
+    ButtonBank bank( m_config );
+    EXPECT_EQ( INPUT, m_io.ReadState( m_pins[0] ).mode );
+}
@@ -0,0 +1,27 @@
+#include "Crc8.h"
+
+namespace samduino
+{
+
+uint8_t Crc8( const uint8_t* data, uint8_t length )
+{
+    uint8_t crc = 0;
+    for ( uint8_t i = 0; i < length; i++ )
+    {
+        uint8_t byte = data[i];
+        for ( uint8_t bit = 0; bit < 8; bit++ )
+        {
+            const uint8_t mix = ( crc ^ byte ) & 0x01;
+            crc >>= 1;
+            if ( mix )
+            {
+                crc ^= 0x8C;
+            }
+            byte >>= 1;
+        }
+    }
+
+    return crc;
+}
+
+} // samduino
@@ -0,0 +1,22 @@
+#ifndef Samduino_Crc8_h
+#define Samduino_Crc8_h
+
+/**
+ * The Dallas/Maxim crc8 (x^8 + x^5 + x^4 + 1) used by 1-Wire devices
+ * and the SettingsStore.
+ */
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+namespace samduino
+{
+
+uint8_t Crc8( const uint8_t* data, uint8_t length );
+
+} // samduino
+
+#endif // c++
+
+#endif
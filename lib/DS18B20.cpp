@@ -0,0 +1,101 @@
+#include "DS18B20.h"
+#include "Arduino.h"
+#include "Crc8.h"
+
+namespace samduino
+{
+
+namespace
+{
+
+// The low 5 bits of the configuration register always read as 1, which
+// tells a real scratchpad apart from a bus stuck low (all 0's has a
+// good crc).
+const uint8_t kConfigIndex = 4;
+const uint8_t kConfigOnes = 0x1F;
+
+}
+
+DS18B20::DS18B20( OneWire& bus, const DS18B20Config& config )
+    : m_bus( bus )
+    , m_config( config )
+    , m_step( Step::kConvertReset )
+    , m_startedAt( 0 )
+    , m_offset( 0 )
+    , m_raw( 0 )
+    , m_hasReading( 0 )
+    , m_errors( 0 )
+{
+}
+
+unsigned long DS18B20::Fail( unsigned long now )
+{
+    m_errors++;
+    m_step = Step::kConvertReset;
+    return now + m_config.PeriodMs;
+}
+
+unsigned long DS18B20::DoWork( unsigned long now )
+{
+    switch ( m_step )
+    {
+    case Step::kConvertReset:
+        if ( !m_bus.Reset() )
+        {
+            return Fail( now );
+        }
+
+        m_startedAt = now;
+        m_step = Step::kConvert;
+        return now;
+
+    case Step::kConvert:
+        m_bus.Write( ONE_WIRE_SKIP_ROM );
+        m_bus.Write( DS18B20_CONVERT_T );
+
+        // Come back when the conversion is done
+        m_step = Step::kReadReset;
+        return now + m_config.ConversionMs;
+
+    case Step::kReadReset:
+        if ( !m_bus.Reset() )
+        {
+            return Fail( now );
+        }
+
+        m_step = Step::kReadCommand;
+        return now;
+
+    case Step::kReadCommand:
+        m_bus.Write( ONE_WIRE_SKIP_ROM );
+        m_bus.Write( DS18B20_READ_SCRATCHPAD );
+
+        m_offset = 0;
+        m_step = Step::kReadData;
+        return now;
+
+    case Step::kReadData:
+        m_scratchpad[m_offset++] = m_bus.Read();
+        if ( m_offset < DS18B20_SCRATCHPAD_SIZE )
+        {
+            return now;
+        }
+
+        if ( Crc8( m_scratchpad, DS18B20_SCRATCHPAD_SIZE - 1 ) != m_scratchpad[DS18B20_SCRATCHPAD_SIZE - 1] ||
+             ( m_scratchpad[kConfigIndex] & kConfigOnes ) != kConfigOnes )
+        {
+            return Fail( now );
+        }
+
+        m_raw = static_cast< int16_t >( m_scratchpad[0] | ( m_scratchpad[1] << 8 ) );
+        m_hasReading = 1;
+
+        // Keep to the period however long the reading took
+        m_step = Step::kConvertReset;
+        return m_startedAt + m_config.PeriodMs;
+    }
+
+    return now;
+}
+
+} // samduino
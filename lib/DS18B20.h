@@ -0,0 +1,101 @@
+#ifndef Samduino_DS18B20_h
+#define Samduino_DS18B20_h
+
+/**
+ * DS18B20 reads a DS18B20 temperature sensor, the only device on its
+ * OneWire bus, without ever blocking the loop on a conversion.
+ *
+ * A conversion takes up to 750ms at the default 12-bit resolution. The
+ * work starts one, returns a deadline for when it will be done and lets
+ * everything else (like a SevenSegmentDisplayWork) run meanwhile. The
+ * bus traffic itself is split into steps of at most a reset or two
+ * bytes, about 1ms, one per tick.
+ *
+ * A reading is only accepted when the scratchpad passes its crc, so a
+ * noisy or disconnected sensor keeps the last good reading and counts an
+ * error instead.
+ */
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+#include "Arduino.h"
+#include "OneWire.h"
+#include "Scheduler.h"
+
+#define DS18B20_CONVERT_T 0x44
+#define DS18B20_READ_SCRATCHPAD 0xBE
+#define DS18B20_SCRATCHPAD_SIZE 9
+
+namespace samduino
+{
+
+struct DS18B20Config
+{
+    // How often to start a new reading
+    unsigned long PeriodMs;
+
+    // How long a conversion takes at the sensor's resolution: 750ms at
+    // 12 bits down to 94ms at 9 bits.
+    unsigned long ConversionMs;
+
+    DS18B20Config()
+        : PeriodMs( 1000 )
+        , ConversionMs( 750 )
+    {}
+};
+
+class DS18B20 : public ScheduledWork
+{
+public:
+    explicit DS18B20( OneWire& bus, const DS18B20Config& config = DS18B20Config() );
+
+    unsigned long DoWork( unsigned long now ) override;
+
+    // HasReading returns true once a reading has passed its crc.
+    bool HasReading() const { return m_hasReading; }
+
+    // Raw returns the last good reading in 1/16ths of a degree C.
+    int16_t Raw() const { return m_raw; }
+
+    // CentiCelsius returns the last good reading in 1/100ths of a
+    // degree C.
+    int16_t CentiCelsius() const
+    {
+        return static_cast< int16_t >( static_cast< int32_t >( m_raw ) * 100 / 16 );
+    }
+
+    // Errors counts the readings lost to a missing sensor or a bad crc.
+    uint16_t Errors() const { return m_errors; }
+
+private:
+    enum class Step : uint8_t
+    {
+        kConvertReset,
+        kConvert,
+        kReadReset,
+        kReadCommand,
+        kReadData
+    };
+
+    unsigned long Fail( unsigned long now );
+
+    OneWire& m_bus;
+    const DS18B20Config m_config;
+
+    Step m_step;
+    unsigned long m_startedAt;
+    uint8_t m_scratchpad[DS18B20_SCRATCHPAD_SIZE];
+    uint8_t m_offset;
+
+    int16_t m_raw;
+    uint8_t m_hasReading;
+    uint16_t m_errors;
+};
+
+} // samduino
+
+#endif // c++
+
+#endif
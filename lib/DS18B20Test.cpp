@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include "ArduinoTestState.h"
+#include "DS18B20.h"
+#include "DS18B20Emulator.h"
+#include "WorkProfiler.h"
+
+using namespace samduino;
+
+namespace
+{
+
+const uint8_t kBusPin = 9;
+
+class DS18B20Test : public ::testing::Test
+{
+public:
+    DS18B20Test()
+        : m_costs( CallCosts::Uno() )
+        , m_sensor( m_time )
+    {
+        m_state.SetTimeProvider( &m_time )
+            .SetInputOutputProvider( &m_io )
+            .SetCallCosts( &m_costs );
+        m_io.AttachDevice( kBusPin, &m_sensor );
+    }
+
+protected:
+    // Run runs the work on 1ms ticks for `ms`.
+    void Run( ScheduledWork& work, unsigned long ms )
+    {
+        unsigned long dueAt = 0;
+        const unsigned long end = millis() + ms;
+        while ( millis() < end )
+        {
+            const unsigned long now = millis();
+            if ( now >= dueAt )
+            {
+                dueAt = work.DoWork( now );
+            }
+
+            m_time.Advance( 1000 );
+        }
+    }
+
+    VirtualTimeProvider m_time;
+    InMemoryInputOutputProvider m_io;
+    CallCosts m_costs;
+    ArduinoTestState m_state;
+    DS18B20Emulator m_sensor;
+};
+
+// Stands in for the display, which must keep its 5ms refresh.
+class RefreshWork : public ScheduledWork
+{
+public:
+    RefreshWork()
+        : m_maxLateMs( 0 )
+        , m_dueAt( 0 )
+    {}
+
+    unsigned long DoWork( unsigned long now ) override
+    {
+        if ( m_dueAt && now - m_dueAt > m_maxLateMs )
+        {
+            m_maxLateMs = now - m_dueAt;
+        }
+
+        m_dueAt = now + 5;
+        return m_dueAt;
+    }
+
+    unsigned long m_maxLateMs;
+
+private:
+    unsigned long m_dueAt;
+};
+
+}
+
+TEST_F( DS18B20Test, ReadsWithoutBlockingTheLoop )
+{
+    m_sensor.SetTemperature( 0x0191 ); // 25.0625C
+
+    OneWire bus( kBusPin );
+    DS18B20 thermometer( bus );
+    RefreshWork refresh;
+    ProfiledWork profiled( thermometer, m_time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+
+    Scheduler scheduler( config );
+    scheduler.AddWork( profiled );
+    scheduler.AddWork( refresh );
+
+    const unsigned long long start = m_time.NowNs();
+    m_time.SetDelayHook( [&]() {
+        if ( m_time.NowNs() - start >= 3000000000ULL )
+        {
+            scheduler.Stop();
+        }
+    });
+    scheduler.Loop();
+
+    ASSERT_TRUE( thermometer.HasReading() );
+    EXPECT_EQ( 0x0191, thermometer.Raw() );
+    EXPECT_EQ( 2506, thermometer.CentiCelsius() );
+    EXPECT_EQ( 0u, thermometer.Errors() );
+    EXPECT_EQ( 3u, m_sensor.Conversions() );
+
+    // No step holds the bus for more than two bytes (~1.2ms), so the
+    // display is never more than a tick late.
+    EXPECT_LT( profiled.MaxNs(), 1300000u );
+    EXPECT_LE( refresh.m_maxLateMs, 1u );
+}
+
+TEST_F( DS18B20Test, RejectsBadReadings )
+{
+    m_sensor.SetTemperature( -0x00A2 ); // -10.125C
+
+    OneWire bus( kBusPin );
+    DS18B20 thermometer( bus );
+
+    Run( thermometer, 1000 );
+    ASSERT_TRUE( thermometer.HasReading() );
+    EXPECT_EQ( -0x00A2, thermometer.Raw() );
+    EXPECT_EQ( -1012, thermometer.CentiCelsius() );
+
+    // A corrupted scratchpad fails its crc and keeps the last reading
+    m_sensor.SetTemperature( 0x0100 );
+    m_sensor.CorruptNextScratchpad();
+    Run( thermometer, 1000 );
+    EXPECT_EQ( -0x00A2, thermometer.Raw() );
+    EXPECT_EQ( 1u, thermometer.Errors() );
+
+    // As does a missing sensor, which reads as all 1's
+    m_sensor.SetConnected( false );
+    Run( thermometer, 1000 );
+    EXPECT_EQ( -0x00A2, thermometer.Raw() );
+    EXPECT_EQ( 2u, thermometer.Errors() );
+
+    m_sensor.SetConnected( true );
+    Run( thermometer, 2000 );
+    EXPECT_EQ( 0x0100, thermometer.Raw() );
+    EXPECT_EQ( 2u, thermometer.Errors() );
+}
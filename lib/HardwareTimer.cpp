@@ -0,0 +1,100 @@
+#include "HardwareTimer.h"
+
+#if defined( __AVR__ )
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+// Defined by HardwareTimerIsr.h along with the interrupt vector. Without
+// the vector, enabling the interrupt would reset the board.
+extern "C" const uint8_t samduinoTimer1Isr __attribute__(( weak ));
+
+namespace
+{
+
+void (* volatile g_timerIsr)( void );
+
+const uint8_t kNumPrescalers = 5;
+const uint16_t kPrescalers[kNumPrescalers] = { 1, 8, 64, 256, 1024 };
+const uint8_t kClockSelects[kNumPrescalers] = {
+    _BV( CS10 ),
+    _BV( CS11 ),
+    _BV( CS11 ) | _BV( CS10 ),
+    _BV( CS12 ),
+    _BV( CS12 ) | _BV( CS10 )
+};
+
+}
+
+extern "C"
+{
+
+bool attachTimerInterrupt( unsigned long periodMicros, void (*isr)( void ) )
+{
+    if ( &samduinoTimer1Isr == 0 )
+    {
+        return false;
+    }
+
+    // Use the finest prescaler which can count out the whole period
+    uint8_t which = 0;
+    unsigned long ticks = 0;
+    for ( ; which < kNumPrescalers; which++ )
+    {
+        ticks = ( F_CPU / 1000000UL ) * periodMicros / kPrescalers[which];
+        if ( ticks <= 0x10000UL )
+        {
+            break;
+        }
+    }
+
+    if ( which == kNumPrescalers )
+    {
+        // Longer than the timer can go; settle for its longest period
+        which = kNumPrescalers - 1;
+        ticks = 0x10000UL;
+    }
+    else if ( ticks == 0 )
+    {
+        ticks = 1;
+    }
+
+    const uint8_t sreg = SREG;
+    cli();
+
+    g_timerIsr = isr;
+
+    // CTC mode, counting up to OCR1A
+    TCCR1A = 0;
+    TCCR1B = _BV( WGM12 ) | kClockSelects[which];
+    TCNT1 = 0;
+    OCR1A = static_cast< uint16_t >( ticks - 1 );
+    TIMSK1 |= _BV( OCIE1A );
+
+    SREG = sreg;
+    return true;
+}
+
+void detachTimerInterrupt( void )
+{
+    const uint8_t sreg = SREG;
+    cli();
+
+    TIMSK1 &= ~_BV( OCIE1A );
+    TCCR1B = 0;
+    g_timerIsr = 0;
+
+    SREG = sreg;
+}
+
+void runTimerInterrupt( void )
+{
+    if ( g_timerIsr )
+    {
+        g_timerIsr();
+    }
+}
+
+}
+
+#endif // __AVR__
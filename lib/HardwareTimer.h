@@ -0,0 +1,47 @@
+#ifndef Samduino_HardwareTimer_h
+#define Samduino_HardwareTimer_h
+
+/**
+ * attachTimerInterrupt() runs a function periodically from a hardware
+ * timer interrupt, and detachTimerInterrupt() stops it.
+ *
+ * The arduino core has no such API. On AVR it is implemented in
+ * HardwareTimer.cpp with Timer1, but the Timer1 interrupt vector is only
+ * defined when a sketch includes HardwareTimerIsr.h, so the library does
+ * not clash with other users of Timer1 (like the Servo library) unless
+ * asked to. Until then attachTimerInterrupt() does nothing and returns
+ * false. In testing it is declared by the Arduino.h shim and emulated in
+ * virtual time.
+ *
+ * Where neither provides it, attachTimerInterrupt is not defined, so code
+ * can test for it with #ifdef.
+ */
+
+#include "Arduino.h"
+
+#if defined( __AVR__ )
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// attachTimerInterrupt returns false, attaching nothing, when the
+// sketch doesn't include HardwareTimerIsr.h.
+bool attachTimerInterrupt( unsigned long periodMicros, void (*isr)( void ) );
+void detachTimerInterrupt( void );
+
+// runTimerInterrupt calls the attached function. It is only meant to be
+// called from the vector defined by HardwareTimerIsr.h.
+void runTimerInterrupt( void );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#define attachTimerInterrupt attachTimerInterrupt
+#define detachTimerInterrupt detachTimerInterrupt
+
+#endif // __AVR__
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef Samduino_HardwareTimerIsr_h
+#define Samduino_HardwareTimerIsr_h
+
+/**
+ * Including this header from a sketch gives the Timer1 compare interrupt
+ * to attachTimerInterrupt(), such as for
+ * SevenSegmentDisplayWork::StartTimerRefresh().
+ *
+ * It defines the interrupt vector, so it must be included from only one
+ * file of the sketch, and not in sketches which use Timer1 otherwise
+ * (like with the Servo or TimerOne libraries). On other cores it does
+ * nothing.
+ */
+
+#include "HardwareTimer.h"
+
+#if defined( __AVR__ )
+
+#include <avr/interrupt.h>
+
+extern "C" const uint8_t samduinoTimer1Isr = 1;
+
+ISR( TIMER1_COMPA_vect )
+{
+    runTimerInterrupt();
+}
+
+#endif // __AVR__
+
+#endif
@@ -0,0 +1,215 @@
+#include "Keypad.h"
+#include "Arduino.h"
+
+namespace samduino
+{
+
+namespace
+{
+
+uint8_t CountBits( uint8_t bits )
+{
+    uint8_t count = 0;
+    for ( ; bits; bits &= bits - 1 )
+    {
+        count++;
+    }
+
+    return count;
+}
+
+}
+
+Keypad::Keypad( const KeypadConfig& config )
+    : m_config( config )
+    , m_numRows( config.NumRows < KEYPAD_MAX_ROWS ? config.NumRows : KEYPAD_MAX_ROWS )
+    , m_numCols( config.NumCols < 8 ? config.NumCols : 8 )
+    , m_row( 0 )
+    , m_depth( config.DebounceScans < KEYPAD_MAX_DEBOUNCE_SCANS ? config.DebounceScans : KEYPAD_MAX_DEBOUNCE_SCANS )
+    , m_slot( 0 )
+    , m_pressed( 0 )
+    , m_ghosts( 0 )
+    , m_head( 0 )
+    , m_tail( 0 )
+    , m_overflows( 0 )
+{
+    while ( m_numRows * m_numCols > KEYPAD_MAX_KEYS )
+    {
+        m_numRows--;
+    }
+
+    if ( m_depth == 0 )
+    {
+        m_depth = 1;
+    }
+
+    // The rows are left alone, as they may belong to a display.
+    for ( uint8_t i = 0; i < m_numRows; i++ )
+    {
+        m_rows[i] = 0;
+    }
+
+    for ( uint8_t i = 0; i < m_numCols; i++ )
+    {
+        pinMode( m_config.ColPins[i], INPUT_PULLUP );
+    }
+
+    for ( uint8_t i = 0; i < KEYPAD_MAX_DEBOUNCE_SCANS; i++ )
+    {
+        m_history[i] = 0;
+    }
+}
+
+uint32_t Keypad::RowMask( uint8_t row ) const
+{
+    return ( ( 1UL << m_numCols ) - 1 ) << ( row * m_numCols );
+}
+
+unsigned long Keypad::DoWork( unsigned long now )
+{
+    if ( m_numRows )
+    {
+        // Only the scanned row is driven. The others float, so two keys
+        // pressed in one column can't short a HIGH row to a LOW one.
+        const uint8_t pin = m_config.RowPins[m_row];
+        pinMode( pin, OUTPUT );
+        digitalWrite( pin, LOW );
+        ScanRow( m_row );
+        pinMode( pin, INPUT );
+
+        m_row = ( m_row + 1 ) % m_numRows;
+    }
+
+    return now + m_config.RowMs;
+}
+
+void Keypad::ScanRow( uint8_t row )
+{
+    if ( row >= m_numRows )
+    {
+        return;
+    }
+
+    uint8_t cols = 0;
+    for ( uint8_t i = 0; i < m_numCols; i++ )
+    {
+        if ( digitalRead( m_config.ColPins[i] ) == LOW )
+        {
+            cols |= 1 << i;
+        }
+    }
+
+    m_rows[row] = cols;
+
+    if ( row == m_numRows - 1 )
+    {
+        EndScan();
+    }
+}
+
+void Keypad::EndScan()
+{
+    uint32_t scan = 0;
+    for ( uint8_t i = 0; i < m_numRows; i++ )
+    {
+        scan |= static_cast< uint32_t >( m_rows[i] ) << ( i * m_numCols );
+    }
+
+    // Rows which share two columns might be showing a ghost
+    uint32_t held = 0;
+    if ( !m_config.Diodes )
+    {
+        for ( uint8_t i = 0; i < m_numRows; i++ )
+        {
+            for ( uint8_t j = i + 1; j < m_numRows; j++ )
+            {
+                if ( CountBits( m_rows[i] & m_rows[j] ) >= 2 )
+                {
+                    held |= RowMask( i ) | RowMask( j );
+                }
+            }
+        }
+
+        if ( held )
+        {
+            m_ghosts++;
+        }
+    }
+
+    m_history[m_slot] = scan;
+    m_slot = ( m_slot + 1 ) % m_depth;
+
+    // A key is pressed once it is in every recent scan and released once
+    // it is in none of them.
+    uint32_t all = 0xFFFFFFFFUL;
+    uint32_t any = 0;
+    for ( uint8_t i = 0; i < m_depth; i++ )
+    {
+        all &= m_history[i];
+        any |= m_history[i];
+    }
+
+    uint32_t pressed = ( m_pressed | all ) & any;
+    pressed = ( pressed & ~held ) | ( m_pressed & held );
+
+    const uint32_t changed = pressed ^ m_pressed;
+    m_pressed = pressed;
+
+    Emit( changed & pressed, ButtonEventType::kPressed );
+    Emit( changed & ~pressed, ButtonEventType::kReleased );
+}
+
+void Keypad::Emit( uint32_t keys, ButtonEventType type )
+{
+    for ( uint8_t key = 0; keys; key++, keys >>= 1 )
+    {
+        if ( !( keys & 1 ) )
+        {
+            continue;
+        }
+
+        const uint8_t head = m_head;
+        if ( static_cast< uint8_t >( head - m_tail ) == KEYPAD_QUEUE_SIZE )
+        {
+            m_overflows++;
+            continue;
+        }
+
+        KeyEvent& event = m_events[head % KEYPAD_QUEUE_SIZE];
+        event.Key = key;
+        event.Type = type;
+
+        // Publish the event only once it is written
+        m_head = head + 1;
+    }
+}
+
+bool Keypad::IsPressed( uint8_t key ) const
+{
+    if ( key >= m_numRows * m_numCols )
+    {
+        return false;
+    }
+
+    // 4 bytes can't be read atomically on AVR
+    const uint8_t sreg = SREG;
+    cli();
+    const uint32_t pressed = m_pressed;
+    SREG = sreg;
+    return ( pressed >> key ) & 1;
+}
+
+bool Keypad::PopEvent( KeyEvent& event )
+{
+    const uint8_t tail = m_tail;
+    if ( m_head == tail )
+    {
+        return false;
+    }
+
+    event = m_events[tail % KEYPAD_QUEUE_SIZE];
+    m_tail = tail + 1;
+    return true;
+}
+
+} // samduino
@@ -0,0 +1,144 @@
+#ifndef Samduino_Keypad_h
+#define Samduino_Keypad_h
+
+/**
+ * The Keypad scans a matrix of keys (like a 4x4 keypad) by driving one
+ * row LOW at a time and reading which columns it pulls LOW through the
+ * pressed keys. The columns use pull-ups, and the rows not being
+ * scanned are left as inputs.
+ *
+ * One row is scanned per tick, the same way SevenSegmentDisplayWork
+ * lights one digit per tick. The two can share the lines: wire the
+ * keypad rows to the display's digit-select pins and
+ * SevenSegmentDisplayWork::AttachKeypad(), and each row is read while
+ * its digit is lit.
+ *
+ * Every key is debounced at once with bitmasks: bit N of each scan is
+ * key N (row * NumCols + col), and a key only changes state once the
+ * last DebounceScans scans agree.
+ *
+ * Any number of keys can be held at once (n-key rollover), except that
+ * without a diode per key, three pressed keys on the corners of a
+ * rectangle also connect the fourth corner. When two rows see the same
+ * two or more columns, either might be such a ghost, so those rows keep
+ * their last state until it clears.
+ */
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+#include "Arduino.h"
+#include "ButtonBank.h"
+#include "Scheduler.h"
+
+#define KEYPAD_MAX_ROWS 8
+#define KEYPAD_MAX_KEYS 32
+#define KEYPAD_MAX_DEBOUNCE_SCANS 8
+#define KEYPAD_QUEUE_SIZE 16
+
+namespace samduino
+{
+
+struct KeypadConfig
+{
+    // NumRows and NumCols-sized arrays of the pins. There may be at
+    // most KEYPAD_MAX_KEYS keys.
+    const uint8_t* RowPins;
+    uint8_t NumRows;
+    const uint8_t* ColPins;
+    uint8_t NumCols;
+
+    // How many whole scans in a row must agree, up to
+    // KEYPAD_MAX_DEBOUNCE_SCANS.
+    uint8_t DebounceScans;
+
+    // How often DoWork() scans the next row
+    unsigned long RowMs;
+
+    // Set when every key has a diode, so there are no ghosts.
+    uint8_t Diodes;
+
+    KeypadConfig()
+        : RowPins( 0 )
+        , NumRows( 0 )
+        , ColPins( 0 )
+        , NumCols( 0 )
+        , DebounceScans( 3 )
+        , RowMs( 5 )
+        , Diodes( 0 )
+    {}
+};
+
+struct KeyEvent
+{
+    // row * NumCols + col
+    uint8_t Key;
+    // kPressed or kReleased
+    ButtonEventType Type;
+};
+
+class Keypad : public ScheduledWork
+{
+public:
+    explicit Keypad( const KeypadConfig& );
+
+    // DoWork drives the next row and scans it, then returns it to an
+    // input. The constructor leaves the row pins alone.
+    unsigned long DoWork( unsigned long now ) override;
+
+    // ScanRow reads the columns for `row`, which someone else has driven
+    // LOW. It is safe to call from an interrupt.
+    void ScanRow( uint8_t row );
+
+    uint8_t NumRows() const { return m_numRows; }
+
+    // PopEvent takes the oldest event off the queue. It returns false
+    // when there are none. It is safe against ScanRow() being called
+    // from an interrupt.
+    bool PopEvent( KeyEvent& );
+
+    // IsPressed returns the debounced state of `key`, or false if there
+    // is no such key. It briefly disables interrupts to read the state in
+    // one piece, then leaves them as they were.
+    bool IsPressed( uint8_t key ) const;
+
+    // Ghosts counts the scans which had to hold rows for ghosting.
+    uint16_t Ghosts() const { return m_ghosts; }
+
+    // Overflows counts the events dropped because the queue was full.
+    uint16_t Overflows() const { return m_overflows; }
+
+private:
+    void EndScan();
+    void Emit( uint32_t keys, ButtonEventType type );
+    uint32_t RowMask( uint8_t row ) const;
+
+    const KeypadConfig m_config;
+    uint8_t m_numRows;
+    uint8_t m_numCols;
+    uint8_t m_row;
+
+    // The columns seen on each row this scan
+    uint8_t m_rows[KEYPAD_MAX_ROWS];
+
+    // The last m_depth scans, where the next one goes, and the debounced
+    // state
+    uint32_t m_history[KEYPAD_MAX_DEBOUNCE_SCANS];
+    uint8_t m_depth;
+    uint8_t m_slot;
+    uint32_t m_pressed;
+
+    uint16_t m_ghosts;
+
+    KeyEvent m_events[KEYPAD_QUEUE_SIZE];
+    volatile uint8_t m_head;
+    volatile uint8_t m_tail;
+    uint16_t m_overflows;
+};
+
+} // samduino
+
+#endif // c++
+
+#endif
@@ -0,0 +1,300 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "ArduinoTestState.h"
+#include "Keypad.h"
+#include "KeypadMatrix.h"
+#include "SevenSegment.h"
+
+using namespace samduino;
+
+namespace
+{
+
+class KeypadTest : public ::testing::Test
+{
+public:
+    KeypadTest()
+        : m_now( 0 )
+    {
+        m_state.SetTimeProvider( &m_time ).SetInputOutputProvider( &m_io );
+
+        // The rows double as the digit selects of a 4-digit display
+        for ( uint8_t i = 0; i < 4; i++ )
+        {
+            m_rowPins[i] = 10 + i;
+            m_colPins[i] = 14 + i;
+        }
+
+        m_config.RowPins = m_rowPins;
+        m_config.NumRows = 4;
+        m_config.ColPins = m_colPins;
+        m_config.NumCols = 4;
+        m_config.DebounceScans = 3;
+    }
+
+protected:
+
+    // Scan scans every row `times` times.
+    void Scan( Keypad& keypad, uint8_t times = 1 )
+    {
+        for ( uint8_t i = 0; i < times * 4; i++ )
+        {
+            m_now = keypad.DoWork( m_now );
+        }
+    }
+
+    std::vector< KeyEvent > Drain( Keypad& keypad )
+    {
+        std::vector< KeyEvent > events;
+        KeyEvent event;
+        while ( keypad.PopEvent( event ) )
+        {
+            events.push_back( event );
+        }
+
+        return events;
+    }
+
+    VirtualTimeProvider m_time;
+    InMemoryInputOutputProvider m_io;
+    ArduinoTestState m_state;
+    uint8_t m_rowPins[4];
+    uint8_t m_colPins[4];
+    KeypadConfig m_config;
+    unsigned long m_now;
+};
+
+}
+
+TEST_F( KeypadTest, DebouncesAndRollsOver )
+{
+    Keypad keypad( m_config );
+    KeypadMatrix matrix( m_io, m_rowPins, 4, m_colPins, 4 );
+
+    // A row is scanned per tick and left floating, while the columns
+    // are pulled up
+    Scan( keypad );
+    EXPECT_EQ( 4 * 5ul, m_now );
+    for ( uint8_t i = 0; i < 4; i++ )
+    {
+        EXPECT_EQ( INPUT, m_io.ReadState( m_rowPins[i] ).mode );
+        EXPECT_EQ( INPUT_PULLUP, m_io.ReadState( m_colPins[i] ).mode );
+    }
+
+    // Bouncing never lasts long enough to register
+    for ( uint8_t i = 0; i < 6; i++ )
+    {
+        matrix.Press( 1, 2, i % 2 == 0 );
+        Scan( keypad );
+    }
+    EXPECT_TRUE( Drain( keypad ).empty() );
+
+    // Once stable it takes 3 scans
+    matrix.Press( 1, 2 );
+    Scan( keypad, 2 );
+    EXPECT_FALSE( keypad.IsPressed( matrix.Key( 1, 2 ) ) );
+    Scan( keypad );
+    EXPECT_TRUE( keypad.IsPressed( matrix.Key( 1, 2 ) ) );
+
+    std::vector< KeyEvent > events = Drain( keypad );
+    ASSERT_EQ( 1u, events.size() );
+    EXPECT_EQ( matrix.Key( 1, 2 ), events[0].Key );
+    EXPECT_EQ( ButtonEventType::kPressed, events[0].Type );
+
+    // Any number of keys with no three on a rectangle
+    matrix.Press( 0, 0 );
+    matrix.Press( 2, 1 );
+    matrix.Press( 3, 3 );
+    Scan( keypad, 3 );
+    EXPECT_EQ( 3u, Drain( keypad ).size() );
+    EXPECT_EQ( 0u, keypad.Ghosts() );
+    for ( uint8_t key = 0; key < 16; key++ )
+    {
+        const bool pressed = key == matrix.Key( 1, 2 ) || key == matrix.Key( 0, 0 ) ||
+            key == matrix.Key( 2, 1 ) || key == matrix.Key( 3, 3 );
+        EXPECT_EQ( pressed, keypad.IsPressed( key ) ) << "key " << int( key );
+    }
+    EXPECT_FALSE( keypad.IsPressed( 16 ) );
+    EXPECT_FALSE( keypad.IsPressed( 255 ) );
+
+    // Reading a key inside a critical section doesn't end it
+    noInterrupts();
+    EXPECT_TRUE( keypad.IsPressed( matrix.Key( 1, 2 ) ) );
+    EXPECT_EQ( 0, SREG & ( 1 << SREG_I ) );
+    interrupts();
+
+    matrix.Release( 1, 2 );
+    Scan( keypad, 3 );
+    events = Drain( keypad );
+    ASSERT_EQ( 1u, events.size() );
+    EXPECT_EQ( matrix.Key( 1, 2 ), events[0].Key );
+    EXPECT_EQ( ButtonEventType::kReleased, events[0].Type );
+}
+
+TEST_F( KeypadTest, HoldsGhostedRows )
+{
+    Keypad keypad( m_config );
+    KeypadMatrix matrix( m_io, m_rowPins, 4, m_colPins, 4 );
+
+    matrix.Press( 0, 0 );
+    matrix.Press( 0, 1 );
+    Scan( keypad, 3 );
+    EXPECT_EQ( 2u, Drain( keypad ).size() );
+
+    // A third corner also connects (1, 1), so neither row can be trusted
+    matrix.Press( 1, 0 );
+    matrix.Press( 3, 3 );
+    Scan( keypad, 5 );
+    EXPECT_EQ( 5u, keypad.Ghosts() );
+    EXPECT_FALSE( keypad.IsPressed( matrix.Key( 1, 0 ) ) );
+    EXPECT_FALSE( keypad.IsPressed( matrix.Key( 1, 1 ) ) );
+    EXPECT_TRUE( keypad.IsPressed( matrix.Key( 0, 1 ) ) );
+
+    // Unaffected rows still work
+    std::vector< KeyEvent > events = Drain( keypad );
+    ASSERT_EQ( 1u, events.size() );
+    EXPECT_EQ( matrix.Key( 3, 3 ), events[0].Key );
+
+    // Once resolved the real key is reported, and never the ghost
+    matrix.Release( 0, 1 );
+    Scan( keypad, 3 );
+    EXPECT_TRUE( keypad.IsPressed( matrix.Key( 1, 0 ) ) );
+    EXPECT_FALSE( keypad.IsPressed( matrix.Key( 1, 1 ) ) );
+    EXPECT_FALSE( keypad.IsPressed( matrix.Key( 0, 1 ) ) );
+    EXPECT_EQ( 2u, Drain( keypad ).size() );
+    EXPECT_EQ( 5u, keypad.Ghosts() );
+
+    // With diodes there are no ghosts to worry about
+    m_config.Diodes = 1;
+    Keypad withDiodes( m_config );
+    matrix.Press( 0, 1 );
+    Scan( withDiodes, 3 );
+    EXPECT_EQ( 0u, withDiodes.Ghosts() );
+}
+
+TEST_F( KeypadTest, KeepsDebouncingPast256Scans )
+{
+    Keypad keypad( m_config );
+    KeypadMatrix matrix( m_io, m_rowPins, 4, m_colPins, 4 );
+    const uint8_t key = matrix.Key( 3, 0 );
+
+    // Every press and release takes exactly 3 scans, however many scans
+    // came before.
+    for ( int i = 0; i < 100; i++ )
+    {
+        matrix.Press( 3, 0 );
+        Scan( keypad, 2 );
+        ASSERT_FALSE( keypad.IsPressed( key ) ) << "cycle " << i;
+        Scan( keypad );
+        ASSERT_TRUE( keypad.IsPressed( key ) ) << "cycle " << i;
+
+        matrix.Release( 3, 0 );
+        Scan( keypad, 2 );
+        ASSERT_TRUE( keypad.IsPressed( key ) ) << "cycle " << i;
+        Scan( keypad );
+        ASSERT_FALSE( keypad.IsPressed( key ) ) << "cycle " << i;
+    }
+}
+
+TEST_F( KeypadTest, SharesRowsWithTheDisplay )
+{
+    VirtualTimeProvider time;
+    CallCosts costs = CallCosts::Uno();
+    m_state.SetTimeProvider( &time ).SetCallCosts( &costs );
+
+    uint8_t bits[4];
+    SevenSegmentState layout;
+    layout.PinA = 2;
+    layout.PinB = 3;
+    layout.PinC = 4;
+    layout.PinD = 5;
+    layout.PinE = 6;
+    layout.PinF = 7;
+    layout.PinG = 8;
+    layout.PinDot = 9;
+    layout.NumD = 4;
+    layout.DPins = m_rowPins;
+    layout.DBits = bits;
+    for ( uint8_t i = 0; i < 4; i++ )
+    {
+        bits[i] = SevenSegment::MakeBits( i );
+    }
+
+    SevenSegment seven( layout );
+    Keypad keypad( m_config );
+    KeypadMatrix matrix( m_io, m_rowPins, 4, m_colPins, 4 );
+
+    // The display scans the keypad from the timer, while the loop just
+    // drains events.
+    SevenSegmentDisplayWork display( seven );
+    ASSERT_TRUE( display.AttachKeypad( keypad ) );
+    ASSERT_TRUE( display.StartTimerRefresh() );
+
+    std::vector< KeyEvent > events;
+    time.Schedule( 100000000ULL, [&]() { matrix.Press( 2, 3 ); } );
+    time.Schedule( 300000000ULL, [&]() { matrix.Release( 2, 3 ); } );
+
+    while ( time.NowNs() < 500000000ULL )
+    {
+        delay( 10 );
+        KeyEvent event;
+        while ( keypad.PopEvent( event ) )
+        {
+            events.push_back( event );
+        }
+    }
+
+    ASSERT_EQ( 2u, events.size() );
+    EXPECT_EQ( matrix.Key( 2, 3 ), events[0].Key );
+    EXPECT_EQ( ButtonEventType::kPressed, events[0].Type );
+    EXPECT_EQ( ButtonEventType::kReleased, events[1].Type );
+
+    // The digits still multiplex as before
+    const uint8_t which = time.TimerFires() % 4;
+    for ( uint8_t i = 0; i < 4; i++ )
+    {
+        EXPECT_EQ( i == which ? LOW : HIGH, m_io.ReadState( m_rowPins[i] ).value );
+    }
+
+    // Reading the keys adds only the column reads to each step
+    display.StopTimerRefresh();
+    SevenSegmentDisplayWork alone( seven );
+
+    unsigned long long before = time.NowNs();
+    alone.Step();
+    const unsigned long long aloneNs = time.NowNs() - before;
+
+    before = time.NowNs();
+    display.Step();
+    EXPECT_EQ( aloneNs + 4 * costs.DigitalReadNs, time.NowNs() - before );
+}
+
+TEST_F( KeypadTest, NeedsADigitPerRow )
+{
+    uint8_t bits[3] = { 0, 0, 0 };
+    SevenSegmentState layout;
+    layout.PinA = 2;
+    layout.PinB = 3;
+    layout.PinC = 4;
+    layout.PinD = 5;
+    layout.PinE = 6;
+    layout.PinF = 7;
+    layout.PinG = 8;
+    layout.PinDot = 9;
+    layout.NumD = 3;
+    layout.DPins = m_rowPins;
+    layout.DBits = bits;
+
+    SevenSegment seven( layout );
+    Keypad keypad( m_config );
+
+    // The fourth row would never be scanned
+    SevenSegmentDisplayWork display( seven );
+    EXPECT_FALSE( display.AttachKeypad( keypad ) );
+
+    m_config.NumRows = 3;
+    Keypad fewer( m_config );
+    EXPECT_TRUE( display.AttachKeypad( fewer ) );
+}
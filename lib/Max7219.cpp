@@ -0,0 +1,89 @@
+#include "Max7219.h"
+#include "Arduino.h"
+#include "SPI.h"
+
+namespace samduino
+{
+
+Max7219::Max7219( SevenSegmentState& state, const Max7219Config& config )
+    : m_state( state )
+    , m_config( config )
+    , m_settings( config.ClockHz, MSBFIRST, SPI_MODE0 )
+    , m_numD( state.NumD < MAX7219_MAX_DIGITS ? state.NumD : MAX7219_MAX_DIGITS )
+{
+    pinMode( m_config.PinCs, OUTPUT );
+    digitalWrite( m_config.PinCs, HIGH );
+
+    SPI.beginTransaction( m_settings );
+    Write( MAX7219_REG_DISPLAY_TEST, 0 );
+    Write( MAX7219_REG_DECODE_MODE, 0 );
+    Write( MAX7219_REG_SCAN_LIMIT, m_numD ? m_numD - 1 : 0 );
+    Write( MAX7219_REG_INTENSITY, m_config.Intensity & 0x0F );
+    for ( uint8_t i = 0; i < m_numD; i++ )
+    {
+        Write( MAX7219_REG_DIGIT0 + i, 0 );
+        m_shown[i] = 0;
+    }
+    Write( MAX7219_REG_SHUTDOWN, 1 );
+    SPI.endTransaction();
+}
+
+void Max7219::Write( uint8_t reg, uint8_t value )
+{
+    // The chip latches the 16 bits shifted in when LOAD rises.
+    uint8_t frame[2] = { reg, value };
+    digitalWrite( m_config.PinCs, LOW );
+    SPI.transfer( frame, sizeof( frame ) );
+    digitalWrite( m_config.PinCs, HIGH );
+}
+
+void Max7219::SetIntensity( uint8_t intensity )
+{
+    SPI.beginTransaction( m_settings );
+    Write( MAX7219_REG_INTENSITY, intensity & 0x0F );
+    SPI.endTransaction();
+}
+
+uint8_t Max7219::Refresh()
+{
+    const uint8_t* dBits = m_state.Frame ? m_state.Frame->Latch() : m_state.DBits;
+    if ( !dBits )
+    {
+        return 0;
+    }
+
+    uint8_t sent = 0;
+    for ( uint8_t i = 0; i < m_numD; i++ )
+    {
+        const uint8_t bits = ToChip( dBits[i] );
+        if ( bits == m_shown[i] )
+        {
+            continue;
+        }
+
+        // Only start a transaction once there is something to send
+        if ( sent == 0 )
+        {
+            SPI.beginTransaction( m_settings );
+        }
+
+        Write( MAX7219_REG_DIGIT0 + i, bits );
+        m_shown[i] = bits;
+        sent++;
+    }
+
+    if ( sent )
+    {
+        SPI.endTransaction();
+    }
+
+    return sent;
+}
+
+unsigned long Max7219::DoWork( unsigned long now )
+{
+    Refresh();
+    return now + m_config.PollMs;
+}
+
+} // samduino
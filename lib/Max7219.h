@@ -0,0 +1,100 @@
+#ifndef Samduino_Max7219_h
+#define Samduino_Max7219_h
+
+/**
+ * Max7219 drives up to 8 digits of 7-segment LEDs through a MAX7219,
+ * which does the multiplexing itself. The loop only has to send a digit
+ * over SPI when it changes, rather than stepping through the digits
+ * every few milliseconds as SevenSegmentDisplayWork does.
+ *
+ * The digits come from a SevenSegmentState's DBits or Frame in the same
+ * bitmap format (see SevenSegment.h), so the same code composes them for
+ * either backend. The state's pins are not used. Only the chip select
+ * (LOAD) pin is needed, along with the SPI bus.
+ */
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "Scheduler.h"
+#include "SevenSegment.h"
+
+#define MAX7219_MAX_DIGITS 8
+
+// The chip's registers
+#define MAX7219_REG_NOOP 0x00
+#define MAX7219_REG_DIGIT0 0x01
+#define MAX7219_REG_DECODE_MODE 0x09
+#define MAX7219_REG_INTENSITY 0x0A
+#define MAX7219_REG_SCAN_LIMIT 0x0B
+#define MAX7219_REG_SHUTDOWN 0x0C
+#define MAX7219_REG_DISPLAY_TEST 0x0F
+
+namespace samduino
+{
+
+struct Max7219Config
+{
+    // The pin wired to LOAD (CS)
+    uint8_t PinCs;
+
+    // Brightness, from 0 to 15
+    uint8_t Intensity;
+
+    // How often DoWork() looks for changed digits
+    unsigned long PollMs;
+
+    // The chip is good to 10 MHz.
+    uint32_t ClockHz;
+
+    Max7219Config()
+        : PinCs( 10 )
+        , Intensity( 8 )
+        , PollMs( 10 )
+        , ClockHz( 8000000 )
+    {}
+};
+
+class Max7219 : public ScheduledWork
+{
+public:
+    // Constructing sets up the chip for state.NumD raw (undecoded) digits
+    // and blanks them. SPI.begin() must already have been called.
+    Max7219( SevenSegmentState& state, const Max7219Config& config );
+
+    unsigned long DoWork( unsigned long now ) override;
+
+    // Refresh sends every digit which differs from what the chip shows,
+    // all in one SPI transaction. It returns how many were sent.
+    uint8_t Refresh();
+
+    // SetIntensity changes the brightness.
+    void SetIntensity( uint8_t intensity );
+
+    // ToChip remaps a bitmap from SevenSegment's abcdefg. order to the
+    // chip's .abcdefg order.
+    static uint8_t ToChip( uint8_t bits )
+    {
+        return static_cast< uint8_t >( ( bits >> 1 ) | ( bits << 7 ) );
+    }
+
+private:
+    void Write( uint8_t reg, uint8_t value );
+
+    SevenSegmentState& m_state;
+    const Max7219Config m_config;
+    const SPISettings m_settings;
+    uint8_t m_numD;
+
+    // What each digit register of the chip holds, in chip order
+    uint8_t m_shown[MAX7219_MAX_DIGITS];
+};
+
+} // samduino
+
+#endif // c++
+
+#endif
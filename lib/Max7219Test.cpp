@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include "ArduinoTestState.h"
+#include "Max7219.h"
+#include "Max7219Emulator.h"
+#include "WorkProfiler.h"
+
+using namespace samduino;
+
+namespace
+{
+
+const uint8_t kCsPin = 15;
+
+class Max7219Test : public ::testing::Test
+{
+public:
+    Max7219Test()
+    {
+        m_state.SetInputOutputProvider( &m_io ).SetSpiProvider( &m_chip );
+        m_io.AttachDevice( kCsPin, &m_chip );
+
+        m_layout.NumD = 4;
+        m_layout.DBits = m_dBits;
+        for ( uint8_t i = 0; i < 4; i++ )
+        {
+            m_dBits[i] = 0;
+        }
+
+        m_config.PinCs = kCsPin;
+    }
+
+protected:
+    InMemoryInputOutputProvider m_io;
+    Max7219Emulator m_chip;
+    ArduinoTestState m_state;
+
+    uint8_t m_dBits[4];
+    SevenSegmentState m_layout;
+    Max7219Config m_config;
+};
+
+// Counts tenths of a second onto the digits, as the timer example does.
+class TenthsWork : public ScheduledWork
+{
+public:
+    explicit TenthsWork( uint8_t* dBits )
+        : m_dBits( dBits )
+    {}
+
+    unsigned long DoWork( unsigned long now ) override
+    {
+        const unsigned long tenths = now / 100;
+        m_dBits[0] = SevenSegment::MakeBits( ( tenths / 1000 ) % 10 );
+        m_dBits[1] = SevenSegment::MakeBits( ( tenths / 100 ) % 10 );
+        m_dBits[2] = SevenSegment::MakeBits( ( tenths / 10 ) % 10, Dotted::kWithDot );
+        m_dBits[3] = SevenSegment::MakeBits( tenths % 10 );
+        return now + 100;
+    }
+
+private:
+    uint8_t* m_dBits;
+};
+
+}
+
+TEST_F( Max7219Test, SetsUpAndRemapsBits )
+{
+    Max7219 max( m_layout, m_config );
+
+    EXPECT_EQ( 0u, m_chip.Torn() );
+    EXPECT_EQ( 0x00, m_chip.Register( MAX7219_REG_DECODE_MODE ) );
+    EXPECT_EQ( 0x03, m_chip.Register( MAX7219_REG_SCAN_LIMIT ) );
+    EXPECT_EQ( 0x08, m_chip.Register( MAX7219_REG_INTENSITY ) );
+    EXPECT_EQ( 0x01, m_chip.Register( MAX7219_REG_SHUTDOWN ) );
+    EXPECT_EQ( 0x00, m_chip.Register( MAX7219_REG_DISPLAY_TEST ) );
+
+    m_dBits[0] = SevenSegment::MakeBits( 0 );
+    m_dBits[1] = SevenSegment::MakeBits( 1, Dotted::kWithDot );
+    m_dBits[2] = SevenSegment::MakeBits( 'E' );
+    m_dBits[3] = SevenSegment::MakeBits( 8, Dotted::kWithDot );
+
+    const size_t transactions = m_chip.Transactions();
+    EXPECT_EQ( 4, max.Refresh() );
+    EXPECT_EQ( transactions + 1, m_chip.Transactions() );
+
+    // The chip's bit 7 is the dot, then a through g
+    EXPECT_EQ( 0x7E, m_chip.Register( MAX7219_REG_DIGIT0 + 0 ) );
+    EXPECT_EQ( 0xB0, m_chip.Register( MAX7219_REG_DIGIT0 + 1 ) );
+    EXPECT_EQ( 0x4F, m_chip.Register( MAX7219_REG_DIGIT0 + 2 ) );
+    EXPECT_EQ( 0xFF, m_chip.Register( MAX7219_REG_DIGIT0 + 3 ) );
+    for ( uint8_t i = 0; i < 4; i++ )
+    {
+        EXPECT_EQ( m_dBits[i], m_chip.Digit( i ) );
+    }
+
+    // Nothing changed, so nothing is sent
+    EXPECT_EQ( 0, max.Refresh() );
+    EXPECT_EQ( transactions + 1, m_chip.Transactions() );
+}
+
+TEST_F( Max7219Test, SendsOnlyChangedDigits )
+{
+    uint8_t dBits[2][4] = {};
+    SevenSegmentFrame frame( dBits[0], dBits[1] );
+    m_layout.DBits = nullptr;
+    m_layout.Frame = &frame;
+
+    Max7219 max( m_layout, m_config );
+    const size_t frames = m_chip.Frames();
+
+    for ( uint8_t value = 0; value < 20; value++ )
+    {
+        uint8_t* back = frame.Back();
+        ASSERT_NE( nullptr, back );
+        back[0] = SevenSegment::MakeBits( 1 );
+        back[1] = SevenSegment::MakeBits( 2, Dotted::kWithDot );
+        back[2] = SevenSegment::MakeBits( value / 10 );
+        back[3] = SevenSegment::MakeBits( value % 10 );
+        frame.Publish();
+
+        max.Refresh();
+        EXPECT_EQ( back[2], m_chip.Digit( 2 ) );
+        EXPECT_EQ( back[3], m_chip.Digit( 3 ) );
+    }
+
+    // 1, 2. and 0 0 once each, then the last digit 19 times and the
+    // tens once.
+    EXPECT_EQ( frames + 4 + 19 + 1, m_chip.Frames() );
+}
+
+TEST_F( Max7219Test, OffloadsMultiplexing )
+{
+    VirtualTimeProvider time;
+    CallCosts costs = CallCosts::Uno();
+    m_state.SetTimeProvider( &time ).SetCallCosts( &costs );
+
+    // The same digits on a directly wired display too
+    uint8_t dPins[4] = { 10, 11, 12, 13 };
+    SevenSegmentState wired;
+    wired.PinA = 2;
+    wired.PinB = 3;
+    wired.PinC = 4;
+    wired.PinD = 5;
+    wired.PinE = 6;
+    wired.PinF = 7;
+    wired.PinG = 8;
+    wired.PinDot = 9;
+    wired.NumD = 4;
+    wired.DPins = dPins;
+    wired.DBits = m_dBits;
+
+    SevenSegment seven( wired );
+    SevenSegmentDisplayWork multiplexed( seven );
+    Max7219 max( m_layout, m_config );
+    TenthsWork tenths( m_dBits );
+
+    ProfiledWork profiledMultiplexed( multiplexed, time );
+    ProfiledWork profiledMax( max, time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+
+    Scheduler scheduler( config );
+    scheduler.AddWork( tenths );
+    scheduler.AddWork( profiledMultiplexed );
+    scheduler.AddWork( profiledMax );
+
+    const unsigned long long start = time.NowNs();
+    time.SetDelayHook( [&]() {
+        if ( time.NowNs() - start >= 1000000000ULL )
+        {
+            scheduler.Stop();
+        }
+    });
+    scheduler.Loop();
+    const unsigned long long elapsed = time.NowNs() - start;
+
+    for ( uint8_t i = 0; i < 4; i++ )
+    {
+        EXPECT_EQ( m_dBits[i], m_chip.Digit( i ) );
+    }
+
+    // The chip costs a small fraction of multiplexing in software.
+    EXPECT_LT( profiledMax.Budget( elapsed ) * 20, profiledMultiplexed.Budget( elapsed ) );
+}
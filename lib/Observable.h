@@ -0,0 +1,99 @@
+#ifndef Samduino_Observable_h
+#define Samduino_Observable_h
+
+/**
+ * An Observable holds a value produced by one work item and consumed by
+ * others, so that the consumers only run when it actually changes.
+ *
+ * The producer Publish()es as often as it likes. Publishing the value
+ * already held does nothing; a new value wakes every dependent through
+ * the Scheduler. A dependent renders from Get() and returns
+ * SCHEDULER_NEVER to sleep until the next change:
+ *
+ *      unsigned long DoWork( unsigned long now ) override
+ *      {
+ *          Render( m_seconds.Get() );
+ *          return SCHEDULER_NEVER;
+ *      }
+ *
+ * Several changes before a dependent gets to run wake it only once, and
+ * it sees the latest value. T needs operator== and assignment.
+ */
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+#include "Scheduler.h"
+
+#define OBSERVABLE_MAX_DEPENDENTS 4
+
+namespace samduino
+{
+
+template < typename T >
+class Observable
+{
+public:
+    explicit Observable( Scheduler& scheduler, const T& initial = T() )
+        : m_scheduler( scheduler )
+        , m_value( initial )
+        , m_version( 0 )
+        , m_numDependents( 0 )
+    {}
+
+    Observable( const Observable& ) = delete;
+
+    // AddDependent adds a work item to wake on every change. It must
+    // also be added to the Scheduler. It returns false if there are
+    // already OBSERVABLE_MAX_DEPENDENTS.
+    bool AddDependent( ScheduledWork& work )
+    {
+        if ( m_numDependents == OBSERVABLE_MAX_DEPENDENTS )
+        {
+            return false;
+        }
+
+        m_dependents[m_numDependents++] = &work;
+        return true;
+    }
+
+    // Publish sets the value. It returns true, having woken the
+    // dependents, only if the value changed.
+    bool Publish( const T& value )
+    {
+        if ( m_value == value )
+        {
+            return false;
+        }
+
+        m_value = value;
+        m_version++;
+
+        for ( uint8_t i = 0; i < m_numDependents; i++ )
+        {
+            m_scheduler.Wake( *m_dependents[i] );
+        }
+
+        return true;
+    }
+
+    const T& Get() const { return m_value; }
+
+    // Version counts the changes, so a dependent of several Observables
+    // can tell which of them changed.
+    uint16_t Version() const { return m_version; }
+
+private:
+    Scheduler& m_scheduler;
+    T m_value;
+    uint16_t m_version;
+    ScheduledWork* m_dependents[OBSERVABLE_MAX_DEPENDENTS];
+    uint8_t m_numDependents;
+};
+
+} // samduino
+
+#endif // c++
+
+#endif
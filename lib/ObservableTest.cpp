@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "ArduinoTestState.h"
+#include "Observable.h"
+
+using namespace samduino;
+
+namespace
+{
+
+class ObservableTest : public ::testing::Test
+{
+public:
+    ObservableTest()
+    {
+        m_state.SetTimeProvider( &m_time );
+    }
+
+protected:
+    // Run loops the scheduler for `ms` of virtual time.
+    void Run( Scheduler& scheduler, unsigned long ms )
+    {
+        const unsigned long long start = m_time.NowNs();
+        m_time.SetDelayHook( [&]() {
+            if ( m_time.NowNs() - start >= ms * 1000000ULL )
+            {
+                scheduler.Stop();
+            }
+        });
+        scheduler.Loop();
+    }
+
+    VirtualTimeProvider m_time;
+    ArduinoTestState m_state;
+};
+
+// Publishes the time in tenths of a second, checking every `periodMs`.
+class TenthsWork : public ScheduledWork
+{
+public:
+    TenthsWork( Observable< unsigned long >& tenths, unsigned long periodMs )
+        : m_tenths( tenths )
+        , m_periodMs( periodMs )
+    {}
+
+    unsigned long DoWork( unsigned long now ) override
+    {
+        m_tenths.Publish( now / 100 );
+        return now + m_periodMs;
+    }
+
+private:
+    Observable< unsigned long >& m_tenths;
+    const unsigned long m_periodMs;
+};
+
+// Records each value it is woken for, and when.
+class RenderWork : public ScheduledWork
+{
+public:
+    explicit RenderWork( Observable< unsigned long >& tenths )
+        : m_tenths( tenths )
+    {}
+
+    unsigned long DoWork( unsigned long now ) override
+    {
+        m_values.push_back( m_tenths.Get() );
+        m_times.push_back( now );
+        return SCHEDULER_NEVER;
+    }
+
+    std::vector< unsigned long > m_values;
+    std::vector< unsigned long > m_times;
+
+private:
+    Observable< unsigned long >& m_tenths;
+};
+
+// Publishes 7, 8 and then 9 all at once.
+class PublishWork : public ScheduledWork
+{
+public:
+    explicit PublishWork( Observable< unsigned long >& value )
+        : m_value( value )
+    {}
+
+    unsigned long DoWork( unsigned long ) override
+    {
+        EXPECT_FALSE( m_value.Publish( 7 ) );
+        EXPECT_TRUE( m_value.Publish( 8 ) );
+        EXPECT_TRUE( m_value.Publish( 9 ) );
+        return SCHEDULER_NEVER;
+    }
+
+private:
+    Observable< unsigned long >& m_value;
+};
+
+}
+
+TEST_F( ObservableTest, RendersOnlyOnChange )
+{
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+    Scheduler scheduler( config );
+
+    Observable< unsigned long > tenths( scheduler );
+    TenthsWork producer( tenths, 10 );
+    RenderWork render( tenths );
+    ASSERT_TRUE( tenths.AddDependent( render ) );
+
+    // The dependent comes first, so it is woken after its turn in the
+    // pass and the loop must come back around for it without sleeping.
+    scheduler.AddWork( render );
+    scheduler.AddWork( producer );
+    Run( scheduler, 1050 );
+
+    // 106 publishes, but only the initial render and 1 per change
+    EXPECT_EQ( 10u, tenths.Version() );
+    ASSERT_EQ( 11u, render.m_values.size() );
+    for ( unsigned long i = 0; i < render.m_values.size(); i++ )
+    {
+        EXPECT_EQ( i, render.m_values[i] );
+        EXPECT_EQ( i * 100, render.m_times[i] );
+    }
+}
+
+TEST_F( ObservableTest, CoalescesChanges )
+{
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+    Scheduler scheduler( config );
+
+    Observable< unsigned long > value( scheduler, 7 );
+    RenderWork first( value );
+    RenderWork second( value );
+    ASSERT_TRUE( value.AddDependent( first ) );
+    ASSERT_TRUE( value.AddDependent( second ) );
+    scheduler.AddWork( first );
+    scheduler.AddWork( second );
+
+    // Unchanged values don't wake anyone; several changes wake once
+    PublishWork publish( value );
+    scheduler.AddWork( publish, 5 );
+    Run( scheduler, 10 );
+
+    ASSERT_EQ( 2u, first.m_values.size() );
+    EXPECT_EQ( 7u, first.m_values[0] );
+    EXPECT_EQ( 9u, first.m_values[1] );
+    EXPECT_EQ( 5u, first.m_times[1] );
+    ASSERT_EQ( 2u, second.m_values.size() );
+    EXPECT_EQ( 9u, second.m_values[1] );
+    EXPECT_EQ( 2u, value.Version() );
+}
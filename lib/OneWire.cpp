@@ -0,0 +1,120 @@
+#include "OneWire.h"
+#include "Arduino.h"
+#include "Crc8.h"
+
+namespace samduino
+{
+
+OneWire::OneWire( uint8_t pin )
+    : m_pin( pin )
+{
+    Release();
+}
+
+void OneWire::DriveLow()
+{
+    pinMode( m_pin, OUTPUT );
+    digitalWrite( m_pin, LOW );
+}
+
+void OneWire::Release()
+{
+    pinMode( m_pin, INPUT );
+}
+
+bool OneWire::Reset()
+{
+    DriveLow();
+    delayMicroseconds( 480 );
+
+    // Devices answer 15-60us after the line is let go by holding it low
+    // for 60-240us.
+    noInterrupts();
+    Release();
+    delayMicroseconds( 70 );
+    const bool present = digitalRead( m_pin ) == LOW;
+    interrupts();
+
+    delayMicroseconds( 410 );
+    return present;
+}
+
+void OneWire::WriteBit( uint8_t bit )
+{
+    // A device samples the line 15-60us into the slot, so a 1 is a pulse
+    // shorter than 15us and a 0 holds the line low past 60us.
+    noInterrupts();
+    DriveLow();
+    if ( bit )
+    {
+        delayMicroseconds( 5 );
+        Release();
+        interrupts();
+        delayMicroseconds( 60 );
+    }
+    else
+    {
+        delayMicroseconds( 60 );
+        Release();
+        interrupts();
+        delayMicroseconds( 5 );
+    }
+}
+
+uint8_t OneWire::ReadBit()
+{
+    // A device sending a 0 holds the line low for at least 15us from the
+    // start of the slot, so it must be sampled well within that. The pin
+    // calls themselves take several us each on the stock core.
+    noInterrupts();
+    DriveLow();
+    delayMicroseconds( 1 );
+    Release();
+    delayMicroseconds( 2 );
+    const uint8_t bit = digitalRead( m_pin ) == HIGH ? 1 : 0;
+    interrupts();
+
+    delayMicroseconds( 55 );
+    return bit;
+}
+
+void OneWire::Write( uint8_t byte )
+{
+    for ( uint8_t i = 0; i < 8; i++ )
+    {
+        WriteBit( byte & 0x01 );
+        byte >>= 1;
+    }
+}
+
+uint8_t OneWire::Read()
+{
+    uint8_t byte = 0;
+    for ( uint8_t i = 0; i < 8; i++ )
+    {
+        if ( ReadBit() )
+        {
+            byte |= 1 << i;
+        }
+    }
+
+    return byte;
+}
+
+bool OneWire::ReadRom( uint8_t rom[ONE_WIRE_ROM_SIZE] )
+{
+    if ( !Reset() )
+    {
+        return false;
+    }
+
+    Write( ONE_WIRE_READ_ROM );
+    for ( uint8_t i = 0; i < ONE_WIRE_ROM_SIZE; i++ )
+    {
+        rom[i] = Read();
+    }
+
+    return Crc8( rom, ONE_WIRE_ROM_SIZE - 1 ) == rom[ONE_WIRE_ROM_SIZE - 1];
+}
+
+} // samduino
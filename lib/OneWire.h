@@ -0,0 +1,61 @@
+#ifndef Samduino_OneWire_h
+#define Samduino_OneWire_h
+
+/**
+ * OneWire drives a Dallas/Maxim 1-Wire bus on a single pin with the
+ * plain arduino pin functions. The line is open-drain with an external
+ * pull-up (4.7k), so the pin only ever pulls it low (an OUTPUT written
+ * LOW) or lets it go (an INPUT).
+ *
+ * Each bit takes a ~70us time slot and a reset ~1ms. These are short
+ * busy-waits with interrupts held off for the timing-critical part of
+ * each slot, so an interrupt can't stretch a pulse into the wrong bit.
+ * Anything longer, like waiting on a temperature conversion, is left to
+ * the caller to yield for (see DS18B20).
+ */
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+#include "Arduino.h"
+
+#define ONE_WIRE_READ_ROM 0x33
+#define ONE_WIRE_SKIP_ROM 0xCC
+#define ONE_WIRE_ROM_SIZE 8
+
+namespace samduino
+{
+
+class OneWire
+{
+public:
+    explicit OneWire( uint8_t pin );
+
+    // Reset resets every device on the bus. It returns true if any
+    // device answered with a presence pulse.
+    bool Reset();
+
+    void WriteBit( uint8_t bit );
+    uint8_t ReadBit();
+
+    // Write and Read transfer a byte, least significant bit first.
+    void Write( uint8_t byte );
+    uint8_t Read();
+
+    // ReadRom reads the ROM code of the only device on the bus. It
+    // returns false if there is no device or the code fails its crc.
+    bool ReadRom( uint8_t rom[ONE_WIRE_ROM_SIZE] );
+
+private:
+    void DriveLow();
+    void Release();
+
+    const uint8_t m_pin;
+};
+
+} // samduino
+
+#endif // c++
+
+#endif
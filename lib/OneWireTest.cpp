@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include "ArduinoTestState.h"
+#include "DS18B20Emulator.h"
+#include "OneWire.h"
+
+using namespace samduino;
+
+namespace
+{
+
+const uint8_t kBusPin = 9;
+
+class OneWireTest : public ::testing::Test
+{
+public:
+    OneWireTest()
+        : m_costs( CallCosts::Uno() )
+        , m_sensor( m_time )
+    {
+        m_state.SetTimeProvider( &m_time )
+            .SetInputOutputProvider( &m_io )
+            .SetCallCosts( &m_costs );
+        m_io.AttachDevice( kBusPin, &m_sensor );
+    }
+
+protected:
+    VirtualTimeProvider m_time;
+    InMemoryInputOutputProvider m_io;
+    CallCosts m_costs;
+    ArduinoTestState m_state;
+    DS18B20Emulator m_sensor;
+};
+
+// A timer interrupt which burns 20us, as a display refresh might
+void BusyIsr()
+{
+    digitalWrite( 2, HIGH );
+    digitalWrite( 2, LOW );
+    delayMicroseconds( 13 );
+}
+
+}
+
+TEST_F( OneWireTest, DetectsPresence )
+{
+    OneWire bus( kBusPin );
+    EXPECT_TRUE( bus.Reset() );
+    EXPECT_EQ( 1u, m_sensor.Resets() );
+
+    m_sensor.SetConnected( false );
+    EXPECT_FALSE( bus.Reset() );
+}
+
+TEST_F( OneWireTest, ReadsRom )
+{
+    OneWire bus( kBusPin );
+
+    uint8_t rom[ONE_WIRE_ROM_SIZE];
+    ASSERT_TRUE( bus.ReadRom( rom ) );
+    for ( uint8_t i = 0; i < ONE_WIRE_ROM_SIZE; i++ )
+    {
+        EXPECT_EQ( m_sensor.Rom()[i], rom[i] ) << "byte " << int( i );
+    }
+
+    m_sensor.SetConnected( false );
+    EXPECT_FALSE( bus.ReadRom( rom ) );
+}
+
+TEST_F( OneWireTest, SlotsSurviveTimerInterrupts )
+{
+    // Interrupts every 37us land in every part of the slots. Without
+    // holding them off, they would stretch 1's into 0's.
+    pinMode( 2, OUTPUT );
+    m_time.AttachTimer( 37, BusyIsr );
+
+    OneWire bus( kBusPin );
+    for ( int i = 0; i < 20; i++ )
+    {
+        uint8_t rom[ONE_WIRE_ROM_SIZE];
+        ASSERT_TRUE( bus.ReadRom( rom ) ) << "attempt " << i;
+        EXPECT_EQ( m_sensor.Rom()[1], rom[1] );
+    }
+
+    m_time.DetachTimer();
+    EXPECT_GT( m_time.TimerFires(), 1000u );
+}
@@ -0,0 +1,116 @@
+#include "RotaryEncoder.h"
+#include "Arduino.h"
+
+namespace samduino
+{
+
+namespace
+{
+
+// Indexed by ( previous AB << 2 ) | current AB. Going clockwise, AB
+// steps through 00, 01, 11, 10. Entries where both bits flip are the
+// missed steps, and are 0 like those where nothing changed.
+const int8_t kTransitions[16] = {
+     0, +1, -1,  0,
+    -1,  0,  0, +1,
+    +1,  0,  0, -1,
+     0, -1, +1,  0
+};
+
+}
+
+RotaryEncoder::RotaryEncoder( const RotaryEncoderConfig& config )
+    : m_config( config )
+    , m_steps( 0 )
+    , m_state( 0 )
+    , m_errors( 0 )
+{
+    pinMode( m_config.PinA, INPUT );
+    pinMode( m_config.PinB, INPUT );
+
+#ifdef portInputRegister
+    m_portA = portInputRegister( digitalPinToPort( m_config.PinA ) );
+    m_portB = portInputRegister( digitalPinToPort( m_config.PinB ) );
+    m_maskA = digitalPinToBitMask( m_config.PinA );
+    m_maskB = digitalPinToBitMask( m_config.PinB );
+#endif
+
+    m_state = Read();
+}
+
+uint8_t RotaryEncoder::Read() const
+{
+#ifdef portInputRegister
+    return ( ( *m_portA & m_maskA ) ? 2 : 0 ) | ( ( *m_portB & m_maskB ) ? 1 : 0 );
+#else
+    return ( digitalRead( m_config.PinA ) ? 2 : 0 ) | ( digitalRead( m_config.PinB ) ? 1 : 0 );
+#endif
+}
+
+void RotaryEncoder::Update()
+{
+    const uint8_t state = Read();
+    const uint8_t previous = m_state;
+    if ( state == previous )
+    {
+        return;
+    }
+
+    if ( ( state ^ previous ) == 3 )
+    {
+        m_errors++;
+    }
+    else
+    {
+        m_steps += kTransitions[( previous << 2 ) | state];
+    }
+
+    m_state = state;
+}
+
+void RotaryEncoder::AttachInterrupts( void (*isr)( void ) )
+{
+    attachInterrupt( digitalPinToInterrupt( m_config.PinA ), isr, CHANGE );
+    attachInterrupt( digitalPinToInterrupt( m_config.PinB ), isr, CHANGE );
+}
+
+void RotaryEncoder::DetachInterrupts()
+{
+    detachInterrupt( digitalPinToInterrupt( m_config.PinA ) );
+    detachInterrupt( digitalPinToInterrupt( m_config.PinB ) );
+}
+
+unsigned long RotaryEncoder::DoWork( unsigned long now )
+{
+    Update();
+    return now + m_config.PollMs;
+}
+
+int32_t RotaryEncoder::Steps() const
+{
+    // 4 bytes can't be read atomically on AVR. Restoring SREG leaves
+    // interrupts as the caller had them.
+    const uint8_t sreg = SREG;
+    cli();
+    const int32_t steps = m_steps;
+    SREG = sreg;
+    return steps;
+}
+
+int32_t RotaryEncoder::Detents() const
+{
+    const uint8_t stepsPerDetent = m_config.StepsPerDetent ? m_config.StepsPerDetent : 1;
+    return Steps() / stepsPerDetent;
+}
+
+uint16_t RotaryEncoder::Errors() const
+{
+    // Nor can 2
+    const uint8_t sreg = SREG;
+    cli();
+    const uint16_t errors = m_errors;
+    SREG = sreg;
+    return errors;
+}
+
+} // samduino
@@ -0,0 +1,100 @@
+#ifndef Samduino_RotaryEncoder_h
+#define Samduino_RotaryEncoder_h
+
+/**
+ * RotaryEncoder decodes a quadrature rotary encoder on two pins, A
+ * and B. Every change of either pin is one step, and the direction
+ * comes from a 16-entry table indexed by the previous and current
+ * state of both pins. A transition where both pins changed at once
+ * means a step was missed, so it is counted as an error instead.
+ *
+ * To never miss a step, Update() should be called from the pins'
+ * interrupts (see AttachInterrupts()). Otherwise it can be polled as
+ * a ScheduledWork, which is only good for knobs turned slowly compared
+ * to the longest work in the loop.
+ *
+ * Where the core provides portInputRegister() the pins are read
+ * straight from their ports, keeping the interrupt short.
+ */
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+#include "Arduino.h"
+#include "Scheduler.h"
+
+namespace samduino
+{
+
+struct RotaryEncoderConfig
+{
+    uint8_t PinA;
+    uint8_t PinB;
+
+    // Most encoders take 4 steps from one detent (click) to the next.
+    uint8_t StepsPerDetent;
+
+    // How often DoWork() polls, when it is scheduled
+    unsigned long PollMs;
+
+    RotaryEncoderConfig()
+        : PinA( 2 )
+        , PinB( 3 )
+        , StepsPerDetent( 4 )
+        , PollMs( 1 )
+    {}
+};
+
+class RotaryEncoder : public ScheduledWork
+{
+public:
+    explicit RotaryEncoder( const RotaryEncoderConfig& );
+
+    // Update reads the pins and counts the step, if any. It is safe to
+    // call from an interrupt.
+    void Update();
+
+    // AttachInterrupts has `isr` called on every change of either pin.
+    // It should just call Update() on this encoder.
+    void AttachInterrupts( void (*isr)( void ) );
+    void DetachInterrupts();
+
+    // DoWork polls Update() instead.
+    unsigned long DoWork( unsigned long now ) override;
+
+    // Steps returns the count of steps, clockwise being positive. It
+    // briefly disables interrupts to read the count in one piece, then
+    // leaves them as they were, so it may be called from anywhere.
+    int32_t Steps() const;
+
+    // Detents returns Steps() in detents, rounded towards 0. A
+    // StepsPerDetent of 0 is taken as 1.
+    int32_t Detents() const;
+
+    // Errors counts the steps known to be missed, read like Steps().
+    uint16_t Errors() const;
+
+private:
+    uint8_t Read() const;
+
+    const RotaryEncoderConfig m_config;
+
+#ifdef portInputRegister
+    volatile uint8_t* m_portA;
+    volatile uint8_t* m_portB;
+    uint8_t m_maskA;
+    uint8_t m_maskB;
+#endif
+
+    // Written from the interrupt
+    volatile int32_t m_steps;
+    volatile uint8_t m_state;
+    volatile uint16_t m_errors;
+};
+
+} // samduino
+
+#endif // c++
+
+#endif
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+
+#include "ArduinoTestState.h"
+#include "EncoderSimulator.h"
+#include "RotaryEncoder.h"
+
+using namespace samduino;
+
+namespace
+{
+
+const uint8_t kPinA = 2;
+const uint8_t kPinB = 3;
+
+// A 24 detent encoder
+const unsigned long kStepsPerRev = 24 * 4;
+
+RotaryEncoder* g_encoder;
+
+void EncoderIsr()
+{
+    g_encoder->Update();
+}
+
+// Stands in for a display refresh on the timer
+void RefreshIsr()
+{
+    for ( int i = 0; i < 10; i++ )
+    {
+        digitalWrite( 13, LOW );
+    }
+}
+
+// Stands in for 1-Wire traffic, which holds interrupts off for each
+// ~70us bit.
+class BitBangWork : public ScheduledWork
+{
+public:
+    unsigned long DoWork( unsigned long now ) override
+    {
+        for ( int i = 0; i < 10; i++ )
+        {
+            noInterrupts();
+            delayMicroseconds( 65 );
+            interrupts();
+            delayMicroseconds( 5 );
+        }
+
+        return now + 1;
+    }
+};
+
+class RotaryEncoderTest : public ::testing::Test
+{
+public:
+    RotaryEncoderTest()
+        : m_costs( CallCosts::Uno() )
+        , m_knob( m_io, m_time, kPinA, kPinB )
+    {
+        m_state.SetTimeProvider( &m_time )
+            .SetInputOutputProvider( &m_io )
+            .SetCallCosts( &m_costs );
+
+        // Getting into and out of an attachInterrupt() isr
+        m_time.SetInterruptNs( 3000 );
+        pinMode( 13, OUTPUT );
+    }
+
+protected:
+    // Turn turns the knob 2 revolutions forward and 1 back at `rpm`
+    // while the loop is busy, with the encoder decoded from interrupts
+    // or polled. It returns the steps the encoder counted.
+    int32_t Turn( unsigned long rpm, bool fromInterrupts, uint16_t& errors )
+    {
+        RotaryEncoderConfig config;
+        config.PinA = kPinA;
+        config.PinB = kPinB;
+        RotaryEncoder encoder( config );
+
+        BitBangWork bitBang;
+        SchedulerConfig schedulerConfig;
+        schedulerConfig.MaxSleepMs = 1000;
+        Scheduler scheduler( schedulerConfig );
+        scheduler.AddWork( bitBang );
+
+        if ( fromInterrupts )
+        {
+            g_encoder = &encoder;
+            encoder.AttachInterrupts( EncoderIsr );
+        }
+        else
+        {
+            scheduler.AddWork( encoder );
+        }
+
+        m_time.AttachTimer( 1000, RefreshIsr );
+
+        const unsigned long long stepNs = EncoderSimulator::StepNsAt( rpm, kStepsPerRev );
+        m_knob.Turn( 2 * kStepsPerRev, stepNs );
+        m_knob.Turn( -static_cast< long >( kStepsPerRev ), stepNs );
+
+        const unsigned long long doneNs = m_knob.DoneNs() + 10000000ULL;
+        m_time.SetDelayHook( [&]() {
+            if ( m_time.NowNs() >= doneNs )
+            {
+                scheduler.Stop();
+            }
+        });
+        scheduler.Loop();
+
+        m_time.DetachTimer();
+        encoder.DetachInterrupts();
+
+        errors = encoder.Errors();
+        return encoder.Steps();
+    }
+
+    VirtualTimeProvider m_time;
+    InMemoryInputOutputProvider m_io;
+    CallCosts m_costs;
+    ArduinoTestState m_state;
+    EncoderSimulator m_knob;
+};
+
+}
+
+TEST_F( RotaryEncoderTest, CountsBothWays )
+{
+    RotaryEncoderConfig config;
+    config.PinA = kPinA;
+    config.PinB = kPinB;
+    RotaryEncoder encoder( config );
+
+    m_knob.Turn( 10, 1000000 );
+    m_knob.Turn( -3, 1000000 );
+    while ( m_time.NowNs() < m_knob.DoneNs() )
+    {
+        m_time.Advance( 100 );
+        encoder.Update();
+    }
+
+    EXPECT_EQ( 7, m_knob.Steps() );
+    EXPECT_EQ( 7, encoder.Steps() );
+    EXPECT_EQ( 1, encoder.Detents() );
+    EXPECT_EQ( 0, encoder.Errors() );
+
+    m_knob.Turn( -15, 1000000 );
+    while ( m_time.NowNs() < m_knob.DoneNs() )
+    {
+        m_time.Advance( 100 );
+        encoder.Update();
+    }
+
+    EXPECT_EQ( -8, encoder.Steps() );
+    EXPECT_EQ( -2, encoder.Detents() );
+
+    // Without detents every step counts
+    config.StepsPerDetent = 0;
+    RotaryEncoder fine( config );
+    m_knob.Turn( 3, 1000000 );
+    while ( m_time.NowNs() < m_knob.DoneNs() )
+    {
+        m_time.Advance( 100 );
+        fine.Update();
+    }
+    EXPECT_EQ( 3, fine.Detents() );
+}
+
+TEST_F( RotaryEncoderTest, LeavesInterruptsAsTheyWere )
+{
+    RotaryEncoderConfig config;
+    config.PinA = kPinA;
+    config.PinB = kPinB;
+    RotaryEncoder encoder( config );
+    g_encoder = &encoder;
+    encoder.AttachInterrupts( EncoderIsr );
+
+    // Reading the counts inside a critical section must not end it
+    noInterrupts();
+    m_knob.Turn( 1, 1000 );
+    m_time.Advance( 10 );
+    EXPECT_EQ( 0, encoder.Steps() );
+    EXPECT_EQ( 0, encoder.Errors() );
+    EXPECT_EQ( 0u, m_time.Interrupts() );
+    EXPECT_EQ( 0, SREG & ( 1 << SREG_I ) );
+
+    interrupts();
+    EXPECT_EQ( 1u, m_time.Interrupts() );
+    EXPECT_EQ( 1, encoder.Steps() );
+    EXPECT_EQ( 1 << SREG_I, SREG & ( 1 << SREG_I ) );
+
+    encoder.DetachInterrupts();
+}
+
+TEST_F( RotaryEncoderTest, KeepsUpAtMaxRpmFromInterrupts )
+{
+    // Our knobs are spec'd to 1000 RPM, a step every 625us.
+    uint16_t errors = 0;
+    EXPECT_EQ( m_knob.Steps(), Turn( 1000, true, errors ) );
+    EXPECT_EQ( 0, errors );
+    EXPECT_GT( m_time.Interrupts(), 3 * kStepsPerRev );
+
+    // Polling every 1ms while the loop is busy can't keep up.
+    const long before = m_knob.Steps();
+    const int32_t polled = Turn( 1000, false, errors );
+    EXPECT_NE( m_knob.Steps() - before, polled );
+    EXPECT_GT( errors, 0 );
+}
+
+TEST_F( RotaryEncoderTest, LosesStepsPastTheLimit )
+{
+    // With interrupts held off for up to 65us, a step every 31us is
+    // sure to be missed now and then, and the decoder knows it.
+    uint16_t errors = 0;
+    EXPECT_NE( m_knob.Steps(), Turn( 20000, true, errors ) );
+    EXPECT_GT( errors, 0 );
+}
@@ -2,6 +2,7 @@
 
 #include "Arduino.h"
 #include "Scheduler.h"
+#include "SchedulerTrace.h"
 
 namespace samduino
 {
@@ -9,8 +10,11 @@ namespace samduino
 Scheduler::Scheduler( SchedulerConfig config )
     : m_config( config )
     , m_stopped( 0 )
+    , m_numWoken( 0 )
     , m_numWorks( 0 )
     , m_works( nullptr )
+    , m_dueAt( nullptr )
+    , m_woken( nullptr )
 {}
 
 Scheduler::~Scheduler()
@@ -19,65 +23,141 @@ Scheduler::~Scheduler()
     {
         delete[] m_works;
     }
+
+    if ( m_dueAt )
+    {
+        delete[] m_dueAt;
+    }
+
+    if ( m_woken )
+    {
+        delete[] m_woken;
+    }
 }
 
-void Scheduler::AddWork( ScheduledWork& work )
+void Scheduler::AddWork( ScheduledWork& work, unsigned long dueAt )
 {
     ScheduledWork** works = new ScheduledWork*[m_numWorks + 1];
+    unsigned long* dues = new unsigned long[m_numWorks + 1];
+    uint8_t* woken = new uint8_t[m_numWorks + 1];
 
     if ( m_works )
     {
         ::memcpy( works, m_works, sizeof( ScheduledWork* ) * m_numWorks );
+        ::memcpy( dues, m_dueAt, sizeof( unsigned long ) * m_numWorks );
+        ::memcpy( woken, m_woken, sizeof( uint8_t ) * m_numWorks );
+        delete[] m_works;
+        delete[] m_dueAt;
+        delete[] m_woken;
     }
     works[m_numWorks] = &work;
+    dues[m_numWorks] = dueAt;
+    woken[m_numWorks] = 0;
 
     m_works = works;
+    m_dueAt = dues;
+    m_woken = woken;
     m_numWorks++;
 }
 
+void Scheduler::Wake( ScheduledWork& work )
+{
+    for ( uint8_t i = 0; i < m_numWorks; i++ )
+    {
+        if ( m_works[i] == &work )
+        {
+            if ( !m_woken[i] )
+            {
+                m_woken[i] = 1;
+                m_numWoken++;
+            }
+            return;
+        }
+    }
+}
+
 void Scheduler::Stop()
 {
     m_stopped = 1;
 }
 
-void Scheduler::Loop()
+unsigned long Scheduler::RunOnce()
 {
-    while ( !m_stopped )
-    {
-        // Don't sleep longer than this
-        unsigned long wakeUpBy = millis() + m_config.MaxSleepMs;
+    // Read the clock once for the whole pass. Work items see this
+    // same snapshot as their `now`.
+    const unsigned long now = millis();
 
-        // todo: it might be nice to bookmark our last index and
-        // start there instead of always starting at work item 0.
+    // Don't sleep longer than this
+    unsigned long wakeUpBy = now + m_config.MaxSleepMs;
 
-        // Run through each of the work items seeing if anyone is ready.
-        for ( uint8_t i = 0; i < m_numWorks; i++ )
-        {
-            ScheduledWork& work = *m_works[i];
+    // todo: it might be nice to bookmark our last index and
+    // start there instead of always starting at work item 0.
 
-            unsigned long now = millis();
-            unsigned long due = work.DueAtMillis();
+    // Run through each of the work items seeing if anyone is ready.
+    for ( uint8_t i = 0; i < m_numWorks; i++ )
+    {
+        unsigned long due = m_dueAt[i];
 
-            // Setup our total delay calculated for this loop
-            if ( now < due )
+        if ( now >= due || m_woken[i] )
+        {
+            // This item is ready. Call it and remember when it wants
+            // to run next. The wake is cleared first, so one it gets
+            // while running (even from itself) is kept for later.
+            if ( m_woken[i] )
             {
-                if ( due < wakeUpBy )
-                {
-                    wakeUpBy = due;
-                }
-
-                continue;
+                m_woken[i] = 0;
+                m_numWoken--;
             }
 
-            // This item is ready. Call it.
-            work.DoWork();
+            const unsigned long traceStart = trace::Now();
+            due = m_works[i]->DoWork( now );
+            trace::Add( i, traceStart, trace::Now() );
+            m_dueAt[i] = due;
+        }
+
+        // Setup our total delay calculated for this loop
+        if ( due < wakeUpBy )
+        {
+            wakeUpBy = due;
+        }
+    }
+
+    // Anyone woken after their turn this pass is due right away, as is
+    // anything which returned a time already gone.
+    if ( m_numWoken || wakeUpBy < now )
+    {
+        return now;
+    }
+
+    return wakeUpBy;
+}
+
+unsigned long Scheduler::RunUntil( unsigned long deadline )
+{
+    while ( true )
+    {
+        const unsigned long wakeUpBy = RunOnce();
+        const unsigned long after = millis();
+        if ( after < wakeUpBy || after >= deadline || m_stopped )
+        {
+            return wakeUpBy;
         }
+    }
+}
+
+void Scheduler::Loop()
+{
+    while ( !m_stopped )
+    {
+        const unsigned long wakeUpBy = RunOnce();
 
         // Now, only sleep for up to wakeUpBy if it still applies
-        unsigned long now = millis();
-        if ( now < wakeUpBy )
+        const unsigned long after = millis();
+        if ( after < wakeUpBy )
         {
-            delay( wakeUpBy - now );
+            const unsigned long traceStart = trace::Now();
+            delay( wakeUpBy - after );
+            trace::Add( SAMDUINO_TRACE_SLEEP, traceStart, trace::Now() );
         }
     }
 }
@@ -12,12 +12,20 @@
 
 #include <stdint.h>
 
+// A deadline which never comes. Work returning it from DoWork() only
+// runs again once woken with Scheduler::Wake().
+#define SCHEDULER_NEVER 0xFFFFFFFFUL
+
 namespace samduino
 {
 
 /**
  * ScheduledWork describes a single recurring work item in the
  * Scheduler.
+ *
+ * The Scheduler owns the deadline of each work item so that it can
+ * decide who is due without calling into the item. The item reports
+ * its next deadline as the return value of DoWork().
  */
 class ScheduledWork
 {
@@ -26,13 +34,12 @@ public:
     ScheduledWork( const ScheduledWork& ) = delete;
     virtual ~ScheduledWork() = default;
 
-    // DueAtMillis returns the time (from millis()) this work's
-    // DoWork() should be called.
-    // Return 0 to indicate it is ready now and avoid the millis() check.
-    virtual unsigned long DueAtMillis() = 0;
-
-    // DoWork executes your work item.
-    virtual void DoWork() = 0;
+    // DoWork executes your work item. `now` is the millis() value read
+    // once by the Scheduler at the start of the current pass.
+    // Return the time (from millis()) this work's DoWork() should next
+    // be called. Return 0 to indicate it is ready again on the next pass,
+    // or SCHEDULER_NEVER to wait until woken.
+    virtual unsigned long DoWork( unsigned long now ) = 0;
 };
 
 struct SchedulerConfig
@@ -59,14 +66,36 @@ public:
 
     Scheduler( const Scheduler& ) = delete;
 
-    // AddWork adds another of your work items to the list. It may only be
-    // called prior to starting the Loop().
-    void AddWork( ScheduledWork& );
+    // AddWork adds another of your work items to the list. It may be called
+    // before starting the Loop(), or between the passes of a RunOnce() or
+    // RunUntil() driven loop, but never from a DoWork(). `dueAt` is the time
+    // (from millis()) the work should first run; the default of 0 runs it
+    // on the next pass.
+    void AddWork( ScheduledWork&, unsigned long dueAt = 0 );
+
+    // Wake makes a work item due right away, whatever deadline it last
+    // returned. It is meant to be called from work items (see
+    // Observable); the Loop() won't sleep before running the woken item.
+    // An item woken during its own DoWork() runs again on the next pass,
+    // whatever it returns.
+    void Wake( ScheduledWork& );
+
+    // RunOnce makes a single pass, running every work item which is due,
+    // and returns the time (from millis()) the next pass should be made.
+    // That is never before the start of this pass nor more than MaxSleepMs
+    // after it. It doesn't delay(), so it can be driven from some other
+    // event loop.
+    unsigned long RunOnce();
+
+    // RunUntil makes passes for as long as something is due right away,
+    // but not past `deadline` (from millis()) or a Stop(), and returns the
+    // time the next pass should be made. Like RunOnce() it never delay()'s.
+    unsigned long RunUntil( unsigned long deadline );
 
     // Loop handles the logic of looping through all work items and
     // delay()'ing as needed between times when nothing is ready to execute.
     // Loop() will run forever or until Stop() (which is only for testing)
-    // is called.
+    // is called. It is just RunOnce() and a delay() until the time returned.
     void Loop();
 
     // Stop is provided as a way to unblock Loop() and it only makes sense to run
@@ -77,8 +106,14 @@ public:
 private:
     const SchedulerConfig m_config;
     volatile uint8_t m_stopped;
+    // How many work items are woken and haven't run since
+    uint8_t m_numWoken;
     uint8_t m_numWorks;
     ScheduledWork** m_works;
+    // Parallel to m_works, the deadline last returned by each work item
+    // and whether it has been woken since it last ran.
+    unsigned long* m_dueAt;
+    uint8_t* m_woken;
 };
 
 } // samduino
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ArduinoTestState.h"
+#include "Scheduler.h"
+#include "SchedulerSoak.h"
+
+using namespace samduino;
+
+namespace
+{
+
+class SchedulerSoakTest : public ::testing::Test
+{
+public:
+    SchedulerSoakTest()
+        : m_costs( CallCosts::Uno() )
+    {
+        m_state.SetTimeProvider( &m_time )
+            .SetCallCosts( &m_costs );
+    }
+
+protected:
+
+    // Soak runs a workload on a fresh clock, reporting any breaches.
+    SoakReport Soak( const SoakConfig& config )
+    {
+        VirtualTimeProvider time;
+        m_state.SetTimeProvider( &time );
+
+        SchedulerSoak soak( config, time, m_costs );
+        const SoakReport report = soak.Run();
+        for ( const std::string& error : report.Errors )
+        {
+            ADD_FAILURE() << "seed " << config.Seed << ": " << error;
+        }
+
+        m_state.SetTimeProvider( &m_time );
+        return report;
+    }
+
+    // Seeds returns how many seeds to soak each workload with. Set
+    // SAMDUINO_SOAK_SEEDS for a longer soak, which also prints a report
+    // of each workload.
+    static uint32_t Seeds()
+    {
+        const char* seeds = getenv( "SAMDUINO_SOAK_SEEDS" );
+        if ( !seeds )
+        {
+            return 2;
+        }
+
+        char* end = nullptr;
+        const unsigned long count = strtoul( seeds, &end, 10 );
+        if ( end == seeds || *end || count == 0 || count > 0xFFFFFFFFUL )
+        {
+            ADD_FAILURE() << "SAMDUINO_SOAK_SEEDS must be a positive count, not \"" << seeds << "\"";
+            return 2;
+        }
+
+        return count;
+    }
+
+    static bool Verbose()
+    {
+        return getenv( "SAMDUINO_SOAK_SEEDS" ) != nullptr;
+    }
+
+    VirtualTimeProvider m_time;
+    CallCosts m_costs;
+    ArduinoTestState m_state;
+};
+
+}
+
+TEST_F( SchedulerSoakTest, KeepsTheContractAsItScales )
+{
+    const uint32_t seeds = Seeds();
+    if ( Verbose() )
+    {
+        printf( "%s\n", SoakReport::Header().c_str() );
+    }
+
+    const uint16_t sizes[] = { 4, 16, 64, 128 };
+    const uint8_t longPercents[] = { 0, 10 };
+
+    for ( uint32_t seed = 1; seed <= seeds; seed++ )
+    {
+        for ( uint16_t items : sizes )
+        {
+            for ( uint8_t longPercent : longPercents )
+            {
+                SoakConfig config;
+                config.Seed = seed;
+                config.NumItems = items;
+                config.MaxItems = items + items / 2;
+                config.LongPercent = longPercent;
+
+                const SoakReport report = Soak( config );
+                if ( Verbose() )
+                {
+                    printf( "%s\n", report.Line( config ).c_str() );
+                }
+
+                EXPECT_EQ( 0u, report.Violations );
+                EXPECT_GT( report.Dispatches, 0u );
+            }
+        }
+    }
+}
+
+TEST_F( SchedulerSoakTest, LightLoadMeetsEveryDeadline )
+{
+    SoakConfig config;
+    config.NumItems = 8;
+    config.MaxItems = 8;
+    config.MinPeriodMs = 5;
+    config.MaxCostUs = 50;
+
+    const SoakReport report = Soak( config );
+    EXPECT_EQ( 0u, report.Violations );
+    EXPECT_EQ( 0u, report.Missed );
+
+    // Nothing waits for more than a pass's worth of short work and the
+    // 1ms resolution of millis().
+    EXPECT_LT( report.MaxUs, 1000u + 8 * 50 + 100 );
+}
+
+TEST_F( SchedulerSoakTest, SameSeedSameReport )
+{
+    SoakConfig config;
+    config.Seed = 42;
+    config.LongPercent = 10;
+    config.ChurnPerMille = 100;
+
+    const SoakReport first = Soak( config );
+    const SoakReport second = Soak( config );
+    EXPECT_EQ( first.Line( config ), second.Line( config ) );
+    EXPECT_GT( first.Adds, 0u );
+    EXPECT_GT( first.Parks, 0u );
+    EXPECT_GT( first.Wakes, 0u );
+
+    config.Seed = 43;
+    EXPECT_NE( first.Line( config ), Soak( config ).Line( config ) );
+}
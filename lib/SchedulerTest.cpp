@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include "Scheduler.h"
 #include "ArduinoTestState.h"
@@ -21,16 +22,24 @@ public:
     }
 
     virtual ~SchedulerTest()
+    {
+        StopScheduler();
+    }
+
+protected:
+
+    // StopScheduler joins the scheduler thread. It must be called before
+    // any work items on the test's stack go out of scope.
+    void StopScheduler()
     {
         if ( m_scheduler )
         {
             m_scheduler->Stop();
             m_thread->join();
+            m_scheduler.reset();
         }
     }
 
-protected:
-
     void StartScheduler( std::unique_ptr< Scheduler >&& scheduler )
     {
         m_scheduler = std::move( scheduler );
@@ -56,13 +65,10 @@ public:
 
     size_t GetCount() const { return m_count; }
 
-    void DoWork() override
+    unsigned long DoWork( unsigned long ) override
     {
         m_count++;
-    }
 
-    unsigned long DueAtMillis() override
-    {
         // Always due
         return 0;
     }
@@ -90,7 +96,374 @@ TEST_F( SchedulerTest, TestScheduling )
 
     // Let the work items run
     std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+    StopScheduler();
 
     // We should have seen a few executions
     EXPECT_NE( counter.GetCount(), 0 );
 }
+
+namespace
+{
+
+// Counts how often the clock is read.
+class CountingTimeProvider : public VirtualTimeProvider
+{
+public:
+    CountingTimeProvider()
+        : m_reads( 0 )
+    {}
+
+    size_t GetReads() const { return m_reads; }
+
+    unsigned long Millis() override
+    {
+        m_reads++;
+        return VirtualTimeProvider::Millis();
+    }
+
+private:
+    size_t m_reads;
+};
+
+class PeriodicWorkItem : public ScheduledWork
+{
+public:
+    explicit PeriodicWorkItem( unsigned long period )
+        : m_period( period )
+        , m_count( 0 )
+        , m_last( 0 )
+    {}
+
+    size_t GetCount() const { return m_count; }
+    unsigned long GetLast() const { return m_last; }
+
+    unsigned long DoWork( unsigned long now ) override
+    {
+        m_count++;
+        m_last = now;
+        return now + m_period;
+    }
+
+private:
+    const unsigned long m_period;
+    size_t m_count;
+    unsigned long m_last;
+};
+
+}
+
+TEST( SchedulerDeadlineTest, HonorsReturnedDeadlines )
+{
+    CountingTimeProvider time;
+    ArduinoTestState state;
+    state.SetTimeProvider( &time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+
+    PeriodicWorkItem fast( 5 );
+    PeriodicWorkItem slow( 20 );
+    PeriodicWorkItem late( 10 );
+
+    Scheduler scheduler( config );
+    scheduler.AddWork( fast );
+    scheduler.AddWork( slow );
+    scheduler.AddWork( late, 50 );
+
+    // Start the clock at 1ms so `fast` and `late` never share a pass.
+    time.Advance( 1000 );
+    time.SetDelayHook( [&]() {
+        if ( time.Micros() >= 100000 )
+        {
+            scheduler.Stop();
+        }
+    });
+    scheduler.Loop();
+
+    // Running at 1, 6, ..., 96 and never sleeping past a deadline.
+    EXPECT_EQ( 20, fast.GetCount() );
+    EXPECT_EQ( 96, fast.GetLast() );
+    EXPECT_EQ( 5, slow.GetCount() );
+    EXPECT_EQ( 5, late.GetCount() );
+    EXPECT_EQ( 90, late.GetLast() );
+
+    // `late` runs at 50, 60, ... in passes of its own. The clock is read once
+    // for the due checks and once for the sleep on each pass, no matter how
+    // many items there are.
+    EXPECT_EQ( 2 * ( fast.GetCount() + late.GetCount() ), time.GetReads() );
+}
+
+namespace
+{
+
+// Always due, taking 1ms each time.
+class BusyWorkItem : public ScheduledWork
+{
+public:
+    explicit BusyWorkItem( VirtualTimeProvider& time )
+        : m_time( time )
+        , m_count( 0 )
+    {}
+
+    size_t GetCount() const { return m_count; }
+
+    unsigned long DoWork( unsigned long ) override
+    {
+        m_count++;
+        m_time.Advance( 1000 );
+        return 0;
+    }
+
+private:
+    VirtualTimeProvider& m_time;
+    size_t m_count;
+};
+
+}
+
+TEST( SchedulerStepTest, RunOnceReturnsTheNextPass )
+{
+    VirtualTimeProvider time;
+    ArduinoTestState state;
+    state.SetTimeProvider( &time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 40;
+
+    PeriodicWorkItem fast( 30 );
+    PeriodicWorkItem slow( 50 );
+
+    Scheduler scheduler( config );
+    scheduler.AddWork( fast );
+    scheduler.AddWork( slow, 100 );
+
+    EXPECT_EQ( 30, scheduler.RunOnce() );
+    EXPECT_EQ( 1, fast.GetCount() );
+
+    // Early passes run nothing
+    time.Advance( 10000 );
+    EXPECT_EQ( 30, scheduler.RunOnce() );
+    EXPECT_EQ( 1, fast.GetCount() );
+
+    time.Advance( 20000 );
+    EXPECT_EQ( 60, scheduler.RunOnce() );
+
+    // Nothing is due within MaxSleepMs of 70
+    time.Advance( 40000 );
+    EXPECT_EQ( 100, scheduler.RunOnce() );
+    EXPECT_EQ( 3, fast.GetCount() );
+    EXPECT_EQ( 0, slow.GetCount() );
+
+    time.Advance( 30000 );
+    EXPECT_EQ( 130, scheduler.RunOnce() );
+    EXPECT_EQ( 4, fast.GetCount() );
+    EXPECT_EQ( 1, slow.GetCount() );
+}
+
+TEST( SchedulerStepTest, AddsWorkBetweenPasses )
+{
+    VirtualTimeProvider time;
+    ArduinoTestState state;
+    state.SetTimeProvider( &time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 40;
+
+    PeriodicWorkItem first( 30 );
+    PeriodicWorkItem second( 20 );
+    PeriodicWorkItem third( 50 );
+
+    Scheduler scheduler( config );
+    scheduler.AddWork( first );
+    EXPECT_EQ( 30, scheduler.RunOnce() );
+
+    // Added work leaves the others' deadlines alone, and first runs on
+    // the next pass or at its `dueAt`.
+    time.Advance( 10000 );
+    scheduler.AddWork( second );
+    scheduler.AddWork( third, 25 );
+    EXPECT_EQ( 25, scheduler.RunOnce() );
+    EXPECT_EQ( 1, first.GetCount() );
+    EXPECT_EQ( 1, second.GetCount() );
+    EXPECT_EQ( 10, second.GetLast() );
+    EXPECT_EQ( 0, third.GetCount() );
+
+    time.Advance( 15000 );
+    EXPECT_EQ( 30, scheduler.RunOnce() );
+    EXPECT_EQ( 1, third.GetCount() );
+
+    time.Advance( 5000 );
+    EXPECT_EQ( 50, scheduler.RunOnce() );
+    EXPECT_EQ( 2, first.GetCount() );
+    EXPECT_EQ( 2, second.GetCount() );
+}
+
+TEST( SchedulerStepTest, RunUntilBoundsAlwaysDueWork )
+{
+    VirtualTimeProvider time;
+    ArduinoTestState state;
+    state.SetTimeProvider( &time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+
+    BusyWorkItem busy( time );
+    Scheduler scheduler( config );
+    scheduler.AddWork( busy );
+
+    // Always due, so it runs until the deadline and says to come back
+    // right away.
+    EXPECT_EQ( 9, scheduler.RunUntil( 10 ) );
+    EXPECT_EQ( 10, busy.GetCount() );
+    EXPECT_EQ( 10, millis() );
+}
+
+TEST( SchedulerStepTest, DrivesManySchedulersFromOneThread )
+{
+    VirtualTimeProvider time;
+    ArduinoTestState state;
+    state.SetTimeProvider( &time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+
+    const size_t kSchedulers = 1000;
+    std::vector< std::unique_ptr< PeriodicWorkItem > > works;
+    std::vector< std::unique_ptr< Scheduler > > schedulers;
+    std::vector< unsigned long > wakeAt( kSchedulers, 0 );
+
+    for ( size_t i = 0; i < kSchedulers; i++ )
+    {
+        works.emplace_back( new PeriodicWorkItem( 10 + i % 37 ) );
+        schedulers.emplace_back( new Scheduler( config ) );
+        schedulers.back()->AddWork( *works.back() );
+    }
+
+    // The event loop: run whoever is due, then skip ahead to the
+    // earliest wake-up.
+    while ( millis() <= 1000 )
+    {
+        unsigned long next = millis() + config.MaxSleepMs;
+        for ( size_t i = 0; i < kSchedulers; i++ )
+        {
+            if ( wakeAt[i] <= millis() )
+            {
+                wakeAt[i] = schedulers[i]->RunUntil( millis() + 1 );
+            }
+
+            if ( wakeAt[i] < next )
+            {
+                next = wakeAt[i];
+            }
+        }
+
+        time.Advance( ( next - millis() ) * 1000 );
+    }
+
+    // Every work ran exactly on each of its deadlines to 1000ms
+    for ( size_t i = 0; i < kSchedulers; i++ )
+    {
+        const unsigned long period = 10 + i % 37;
+        EXPECT_EQ( 1000 / period + 1, works[i]->GetCount() ) << "scheduler " << i;
+        EXPECT_EQ( 1000 / period * period, works[i]->GetLast() ) << "scheduler " << i;
+    }
+}
+
+namespace
+{
+
+// Wakes `target` (which may be itself) the first `wakes` times it runs,
+// then waits to be woken.
+class WakingWorkItem : public ScheduledWork
+{
+public:
+    WakingWorkItem( Scheduler& scheduler, size_t wakes )
+        : m_scheduler( scheduler )
+        , m_target( this )
+        , m_wakes( wakes )
+        , m_count( 0 )
+    {}
+
+    void SetTarget( ScheduledWork& target ) { m_target = &target; }
+    size_t GetCount() const { return m_count; }
+
+    unsigned long DoWork( unsigned long ) override
+    {
+        m_count++;
+        if ( m_wakes )
+        {
+            m_wakes--;
+            m_scheduler.Wake( *m_target );
+        }
+        return SCHEDULER_NEVER;
+    }
+
+private:
+    Scheduler& m_scheduler;
+    ScheduledWork* m_target;
+    size_t m_wakes;
+    size_t m_count;
+};
+
+}
+
+TEST( SchedulerStepTest, KeepsAWakeFromItsOwnDoWork )
+{
+    VirtualTimeProvider time;
+    ArduinoTestState state;
+    state.SetTimeProvider( &time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 40;
+
+    Scheduler scheduler( config );
+    WakingWorkItem self( scheduler, 2 );
+    scheduler.AddWork( self );
+
+    // Each wake it gives itself holds until the next pass
+    EXPECT_EQ( 0, scheduler.RunOnce() );
+    EXPECT_EQ( 1, self.GetCount() );
+    EXPECT_EQ( 0, scheduler.RunOnce() );
+    EXPECT_EQ( 2, self.GetCount() );
+    EXPECT_EQ( 40, scheduler.RunOnce() );
+    EXPECT_EQ( 3, self.GetCount() );
+    EXPECT_EQ( 40, scheduler.RunOnce() );
+    EXPECT_EQ( 3, self.GetCount() );
+}
+
+TEST( SchedulerStepTest, OnlyWakesAfterTheirTurnForceAPass )
+{
+    VirtualTimeProvider time;
+    ArduinoTestState state;
+    state.SetTimeProvider( &time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 40;
+
+    Scheduler scheduler( config );
+    WakingWorkItem first( scheduler, 1 );
+    WakingWorkItem second( scheduler, 1 );
+    WakingWorkItem third( scheduler, 0 );
+    scheduler.AddWork( first );
+    scheduler.AddWork( second, SCHEDULER_NEVER );
+    scheduler.AddWork( third, SCHEDULER_NEVER );
+    first.SetTarget( third );
+    second.SetTarget( first );
+
+    // `first` wakes `third` before its turn, so it runs in the same pass
+    // and there is no need to come straight back.
+    EXPECT_EQ( 40, scheduler.RunOnce() );
+    EXPECT_EQ( 1, first.GetCount() );
+    EXPECT_EQ( 1, third.GetCount() );
+
+    // But when `second` wakes `first` after its turn, there is.
+    scheduler.Wake( second );
+    EXPECT_EQ( 0, scheduler.RunOnce() );
+    EXPECT_EQ( 1, first.GetCount() );
+    EXPECT_EQ( 1, second.GetCount() );
+
+    EXPECT_EQ( 40, scheduler.RunOnce() );
+    EXPECT_EQ( 2, first.GetCount() );
+    EXPECT_EQ( 1, second.GetCount() );
+    EXPECT_EQ( 1, third.GetCount() );
+}
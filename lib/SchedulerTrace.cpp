@@ -0,0 +1,62 @@
+#include "SchedulerTrace.h"
+
+#if defined( SAMDUINO_TRACE )
+
+namespace samduino
+{
+
+namespace trace
+{
+
+Record g_records[SAMDUINO_TRACE_SIZE];
+uint16_t g_next;
+uint8_t g_wrapped;
+
+namespace
+{
+
+void Put32( uint8_t* out, unsigned long value )
+{
+    out[0] = static_cast< uint8_t >( value );
+    out[1] = static_cast< uint8_t >( value >> 8 );
+    out[2] = static_cast< uint8_t >( value >> 16 );
+    out[3] = static_cast< uint8_t >( value >> 24 );
+}
+
+}
+
+uint16_t Read( uint8_t* out, uint16_t size )
+{
+    // Oldest first: once wrapped, that is the next one to be overwritten.
+    const uint16_t first = g_wrapped ? g_next : 0;
+    const uint16_t held = g_wrapped ? SAMDUINO_TRACE_SIZE : g_next;
+
+    uint16_t written = 0;
+    for ( uint16_t i = 0; i < held; i++ )
+    {
+        if ( size - written < SAMDUINO_TRACE_RECORD_SIZE )
+        {
+            break;
+        }
+
+        const Record& record = g_records[( first + i ) % SAMDUINO_TRACE_SIZE];
+        out[written] = record.Id;
+        Put32( out + written + 1, record.StartUs );
+        Put32( out + written + 5, record.DurationUs );
+        written += SAMDUINO_TRACE_RECORD_SIZE;
+    }
+
+    return written;
+}
+
+void Clear()
+{
+    g_next = 0;
+    g_wrapped = 0;
+}
+
+} // trace
+
+} // samduino
+
+#endif // SAMDUINO_TRACE
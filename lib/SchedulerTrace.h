@@ -0,0 +1,103 @@
+#ifndef Samduino_SchedulerTrace_h
+#define Samduino_SchedulerTrace_h
+
+/**
+ * Scheduler tracing records when each ScheduledWork's DoWork() ran and
+ * for how long, along with each delay() between passes, into a small
+ * static ring buffer of fixed-size records.
+ *
+ * Unless SAMDUINO_TRACE is defined, tracing is off and all of this
+ * compiles to nothing. It has to be defined for the library as well as
+ * the sketch, which a #define in the sketch can't do: uncomment the one
+ * below, or add -DSAMDUINO_TRACE to the build flags. When on, each record
+ * costs two micros() calls, one at each end of the span, and a few
+ * stores.
+ *
+ * Read() serializes the buffer, which can be sent to the host (over
+ * Serial, say) and turned into a Chrome trace for viewing in Perfetto.
+ * Each record is 9 bytes, little-endian:
+ *
+ *      | id (1) | start micros (4) | duration micros (4) |
+ *
+ * where the id is the index of the work in its Scheduler, or
+ * SAMDUINO_TRACE_SLEEP for a delay().
+ */
+
+// #define SAMDUINO_TRACE
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+#include "Arduino.h"
+
+#ifndef SAMDUINO_TRACE_SIZE
+#define SAMDUINO_TRACE_SIZE 32
+#endif
+
+#define SAMDUINO_TRACE_SLEEP 0xFF
+#define SAMDUINO_TRACE_RECORD_SIZE 9
+
+namespace samduino
+{
+
+namespace trace
+{
+
+#if defined( SAMDUINO_TRACE )
+
+struct Record
+{
+    unsigned long StartUs;
+    unsigned long DurationUs;
+    uint8_t Id;
+};
+
+// The ring buffer, where the next record goes, and whether it has
+// wrapped around yet
+extern Record g_records[SAMDUINO_TRACE_SIZE];
+extern uint16_t g_next;
+extern uint8_t g_wrapped;
+
+inline unsigned long Now()
+{
+    return micros();
+}
+
+inline void Add( uint8_t id, unsigned long startUs, unsigned long endUs )
+{
+    Record& record = g_records[g_next];
+    record.StartUs = startUs;
+    record.DurationUs = endUs - startUs;
+    record.Id = id;
+
+    if ( ++g_next == SAMDUINO_TRACE_SIZE )
+    {
+        g_next = 0;
+        g_wrapped = 1;
+    }
+}
+
+// Read serializes up to `size` bytes of the buffered records, oldest
+// first, and returns how many bytes were written.
+uint16_t Read( uint8_t* out, uint16_t size );
+
+// Clear empties the buffer.
+void Clear();
+
+#else
+
+inline unsigned long Now() { return 0; }
+inline void Add( uint8_t, unsigned long, unsigned long ) {}
+inline uint16_t Read( uint8_t*, uint16_t ) { return 0; }
+inline void Clear() {}
+
+#endif
+
+} // trace
+
+} // samduino
+
+#endif // c++
+
+#endif
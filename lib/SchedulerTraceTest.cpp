@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include "ArduinoTestState.h"
+#include "ChromeTrace.h"
+#include "Scheduler.h"
+#include "SchedulerTrace.h"
+
+using namespace samduino;
+
+#if defined( SAMDUINO_TRACE )
+
+namespace
+{
+
+// Takes 300us every 2ms
+class BusyWork : public ScheduledWork
+{
+public:
+    unsigned long DoWork( unsigned long now ) override
+    {
+        delayMicroseconds( 300 );
+        return now + 2;
+    }
+};
+
+}
+
+TEST( SchedulerTraceTest, RecordsWorkAndSleeps )
+{
+    VirtualTimeProvider time;
+    ArduinoTestState state;
+    state.SetTimeProvider( &time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+
+    BusyWork busy;
+    Scheduler scheduler( config );
+    scheduler.AddWork( busy );
+
+    size_t passes = 0;
+    time.SetDelayHook( [&]() {
+        if ( ++passes == 2 )
+        {
+            scheduler.Stop();
+        }
+    });
+
+    trace::Clear();
+    scheduler.Loop();
+
+    uint8_t dump[SAMDUINO_TRACE_SIZE * SAMDUINO_TRACE_RECORD_SIZE];
+    const uint16_t size = trace::Read( dump, sizeof( dump ) );
+    ASSERT_EQ( 4 * SAMDUINO_TRACE_RECORD_SIZE, size );
+
+    EXPECT_EQ(
+        "{\"traceEvents\":["
+        "{\"name\":\"busy\",\"cat\":\"work\",\"ph\":\"X\",\"ts\":0,\"dur\":300,\"pid\":0,\"tid\":0},"
+        "{\"name\":\"delay\",\"cat\":\"sleep\",\"ph\":\"X\",\"ts\":300,\"dur\":2000,\"pid\":0,\"tid\":0},"
+        "{\"name\":\"busy\",\"cat\":\"work\",\"ph\":\"X\",\"ts\":2300,\"dur\":300,\"pid\":0,\"tid\":0},"
+        "{\"name\":\"delay\",\"cat\":\"sleep\",\"ph\":\"X\",\"ts\":2600,\"dur\":2000,\"pid\":0,\"tid\":0}"
+        "]}",
+        DecodeChromeTrace( dump, size, { "busy" } ) );
+}
+
+TEST( SchedulerTraceTest, KeepsTheNewestRecords )
+{
+    trace::Clear();
+    for ( unsigned long i = 0; i < SAMDUINO_TRACE_SIZE + 3; i++ )
+    {
+        trace::Add( 1, i * 10, i * 10 + 5 );
+    }
+
+    uint8_t dump[SAMDUINO_TRACE_SIZE * SAMDUINO_TRACE_RECORD_SIZE];
+    ASSERT_EQ( sizeof( dump ), trace::Read( dump, sizeof( dump ) ) );
+
+    // The oldest 3 were overwritten
+    EXPECT_EQ( 30, dump[1] );
+    EXPECT_EQ( 1, dump[0] );
+
+    // And a short buffer gets only whole records
+    EXPECT_EQ( SAMDUINO_TRACE_RECORD_SIZE, trace::Read( dump, SAMDUINO_TRACE_RECORD_SIZE + 4 ) );
+    trace::Clear();
+}
+
+#endif // SAMDUINO_TRACE
+
+TEST( SchedulerTraceTest, DecodesAcrossMicrosWrap )
+{
+    const uint8_t dump[] = {
+        2, 0xF0, 0xFF, 0xFF, 0xFF, 0x20, 0, 0, 0,
+        SAMDUINO_TRACE_SLEEP, 0x10, 0, 0, 0, 0x08, 0, 0, 0
+    };
+
+    EXPECT_EQ(
+        "{\"traceEvents\":["
+        "{\"name\":\"work 2\",\"cat\":\"work\",\"ph\":\"X\",\"ts\":4294967280,\"dur\":32,\"pid\":0,\"tid\":0},"
+        "{\"name\":\"delay\",\"cat\":\"sleep\",\"ph\":\"X\",\"ts\":4294967312,\"dur\":8,\"pid\":0,\"tid\":0}"
+        "]}",
+        DecodeChromeTrace( dump, sizeof( dump ) ) );
+}
+
+TEST( SchedulerTraceTest, EscapesWorkNames )
+{
+    const uint8_t dump[] = {
+        0, 0x10, 0, 0, 0, 0x08, 0, 0, 0
+    };
+
+    EXPECT_EQ(
+        "{\"traceEvents\":["
+        "{\"name\":\"say \\\"hi\\\" \\\\ bye\\u000a\",\"cat\":\"work\",\"ph\":\"X\",\"ts\":16,\"dur\":8,\"pid\":0,\"tid\":0}"
+        "]}",
+        DecodeChromeTrace( dump, sizeof( dump ), { "say \"hi\" \\ bye\n" } ) );
+}
@@ -0,0 +1,296 @@
+#include "SettingsStore.h"
+#include "Arduino.h"
+#include "Crc8.h"
+
+namespace samduino
+{
+
+namespace
+{
+
+const uint16_t kNoSlot = 0xFFFF;
+const uint8_t kNoKey = 0xFF;
+const uint32_t kErasedSeq = 0xFFFFFFFFUL;
+
+void Put32( uint8_t* data, uint32_t value )
+{
+    data[0] = static_cast< uint8_t >( value );
+    data[1] = static_cast< uint8_t >( value >> 8 );
+    data[2] = static_cast< uint8_t >( value >> 16 );
+    data[3] = static_cast< uint8_t >( value >> 24 );
+}
+
+uint32_t Get32( const uint8_t* data )
+{
+    return static_cast< uint32_t >( data[0] ) |
+        ( static_cast< uint32_t >( data[1] ) << 8 ) |
+        ( static_cast< uint32_t >( data[2] ) << 16 ) |
+        ( static_cast< uint32_t >( data[3] ) << 24 );
+}
+
+uint8_t* Address( uint16_t address )
+{
+    return reinterpret_cast< uint8_t* >( address );
+}
+
+// The check byte is the complement of the crc8, since a record of all
+// 0's has a crc8 of 0 and zeroed EEPROM would look like a setting.
+uint8_t Check( const uint8_t* record )
+{
+    return static_cast< uint8_t >( ~Crc8( record, SETTINGS_STORE_RECORD_SIZE - 1 ) );
+}
+
+}
+
+SettingsStore::SettingsStore( const SettingsStoreConfig& config )
+    : m_config( config )
+    , m_numSlots( config.Size / SETTINGS_STORE_RECORD_SIZE )
+    , m_numEntries( 0 )
+    , m_nextSeq( 0 )
+    , m_head( 0 )
+    , m_writing( 0 )
+    , m_offset( 0 )
+    , m_writeKey( kNoKey )
+    , m_writeSlot( kNoSlot )
+{
+    Recover();
+}
+
+void SettingsStore::Recover()
+{
+    uint8_t record[SETTINGS_STORE_RECORD_SIZE];
+    bool found = false;
+    uint32_t newest = 0;
+
+    for ( uint16_t slot = 0; slot < m_numSlots; slot++ )
+    {
+        const uint16_t base = m_config.Base + slot * SETTINGS_STORE_RECORD_SIZE;
+        for ( uint8_t i = 0; i < SETTINGS_STORE_RECORD_SIZE; i++ )
+        {
+            record[i] = eeprom_read_byte( Address( base + i ) );
+        }
+
+        // Skip erased and torn records
+        const uint32_t seq = Get32( record );
+        const uint8_t key = record[4];
+        if ( seq == kErasedSeq || key == kNoKey ||
+             Check( record ) != record[SETTINGS_STORE_RECORD_SIZE - 1] )
+        {
+            continue;
+        }
+
+        if ( !found || seq > newest )
+        {
+            found = true;
+            newest = seq;
+            m_head = ( slot + 1 ) % m_numSlots;
+        }
+
+        Entry* entry = Find( key );
+        if ( !entry )
+        {
+            if ( m_numEntries == SETTINGS_STORE_MAX_KEYS )
+            {
+                continue;
+            }
+
+            entry = &m_entries[m_numEntries++];
+            entry->Key = key;
+            entry->Dirty = 0;
+        }
+        else if ( seq < entry->Seq )
+        {
+            continue;
+        }
+
+        entry->Seq = seq;
+        entry->Slot = slot;
+        entry->Value = Get32( record + 5 );
+    }
+
+    m_nextSeq = found ? newest + 1 : 0;
+}
+
+SettingsStore::Entry* SettingsStore::Find( uint8_t key )
+{
+    for ( uint8_t i = 0; i < m_numEntries; i++ )
+    {
+        if ( m_entries[i].Key == key )
+        {
+            return &m_entries[i];
+        }
+    }
+
+    return nullptr;
+}
+
+const SettingsStore::Entry* SettingsStore::Find( uint8_t key ) const
+{
+    return const_cast< SettingsStore* >( this )->Find( key );
+}
+
+bool SettingsStore::IsLive( uint16_t slot ) const
+{
+    for ( uint8_t i = 0; i < m_numEntries; i++ )
+    {
+        if ( m_entries[i].Slot == slot )
+        {
+            return true;
+        }
+    }
+
+    // The slot being written will be live once it is done
+    return m_writing && m_writeSlot == slot;
+}
+
+bool SettingsStore::Get( uint8_t key, uint32_t& value ) const
+{
+    const Entry* entry = Find( key );
+    if ( !entry )
+    {
+        return false;
+    }
+
+    value = entry->Value;
+    return true;
+}
+
+bool SettingsStore::Set( uint8_t key, uint32_t value )
+{
+    if ( key == kNoKey )
+    {
+        return false;
+    }
+
+    Entry* entry = Find( key );
+    if ( !entry )
+    {
+        if ( m_numEntries == SETTINGS_STORE_MAX_KEYS )
+        {
+            return false;
+        }
+
+        entry = &m_entries[m_numEntries++];
+        entry->Key = key;
+        entry->Seq = 0;
+        entry->Slot = kNoSlot;
+    }
+    else if ( entry->Value == value )
+    {
+        return true;
+    }
+
+    entry->Value = value;
+    entry->Dirty = 1;
+    return true;
+}
+
+bool SettingsStore::IsIdle() const
+{
+    if ( m_writing )
+    {
+        return false;
+    }
+
+    for ( uint8_t i = 0; i < m_numEntries; i++ )
+    {
+        if ( m_entries[i].Dirty )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void SettingsStore::StartWrite( Entry& entry )
+{
+    // Use the next record at or after the head which doesn't hold
+    // anyone's current value.
+    uint16_t slot = kNoSlot;
+    for ( uint16_t i = 0; i < m_numSlots; i++ )
+    {
+        const uint16_t candidate = ( m_head + i ) % m_numSlots;
+        if ( !IsLive( candidate ) )
+        {
+            slot = candidate;
+            break;
+        }
+    }
+
+    if ( slot == kNoSlot )
+    {
+        // Every record is live. There are more keys than the region
+        // can hold and this one stays dirty.
+        return;
+    }
+
+    Put32( m_record, m_nextSeq );
+    m_record[4] = entry.Key;
+    Put32( m_record + 5, entry.Value );
+    m_record[SETTINGS_STORE_RECORD_SIZE - 1] = Check( m_record );
+
+    m_nextSeq++;
+    entry.Dirty = 0;
+
+    m_writing = 1;
+    m_offset = 0;
+    m_writeKey = entry.Key;
+    m_writeSlot = slot;
+}
+
+unsigned long SettingsStore::DoWork( unsigned long now )
+{
+    // A byte is still being written; never block on it.
+    if ( !eeprom_is_ready() )
+    {
+        return now + 1;
+    }
+
+    if ( !m_writing )
+    {
+        for ( uint8_t i = 0; i < m_numEntries && !m_writing; i++ )
+        {
+            if ( m_entries[i].Dirty )
+            {
+                StartWrite( m_entries[i] );
+            }
+        }
+
+        if ( !m_writing )
+        {
+            return now + m_config.IdlePollMs;
+        }
+    }
+
+    // Write the next byte which differs from what is already there.
+    const uint16_t base = m_config.Base + m_writeSlot * SETTINGS_STORE_RECORD_SIZE;
+    while ( m_offset < SETTINGS_STORE_RECORD_SIZE )
+    {
+        uint8_t* address = Address( base + m_offset );
+        const uint8_t byte = m_record[m_offset++];
+
+        if ( eeprom_read_byte( address ) != byte )
+        {
+            eeprom_write_byte( address, byte );
+            break;
+        }
+    }
+
+    if ( m_offset == SETTINGS_STORE_RECORD_SIZE )
+    {
+        // The new record supersedes the old one. The old one won't be
+        // overwritten before this last byte is done since every write
+        // waits for eeprom_is_ready().
+        Entry* entry = Find( m_writeKey );
+        entry->Seq = Get32( m_record );
+        entry->Slot = m_writeSlot;
+
+        m_head = ( m_writeSlot + 1 ) % m_numSlots;
+        m_writing = 0;
+    }
+
+    return now + 1;
+}
+
+} // samduino
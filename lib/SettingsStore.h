@@ -0,0 +1,116 @@
+#ifndef Samduino_SettingsStore_h
+#define Samduino_SettingsStore_h
+
+/**
+ * The SettingsStore keeps small key/value settings (calibrations,
+ * display preferences, ...) in EEPROM without wearing it out or blocking
+ * the loop.
+ *
+ * The EEPROM region is used as a log of fixed-size records:
+ *
+ *      | seq (4) | key (1) | value (4) | ~crc8 (1) |
+ *
+ * The crc8 is stored complemented so that zeroed EEPROM, whose crc8
+ * would check, holds no records.
+ *
+ * Each Set() appends a new record rather than rewriting the old one, so
+ * writes are spread over the whole region. Records still holding the
+ * current value of a key are never overwritten, which means losing power
+ * part way through a write can only ever tear the new record; on the
+ * next boot its crc fails and the previous value is used.
+ *
+ * Writing is done by the store's ScheduledWork one byte per tick, and
+ * only once the EEPROM is ready, so the loop never waits on a write.
+ * The 32-bit sequence number orders records. The EEPROM wears out long
+ * before it can wrap.
+ */
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+#include "Arduino.h"
+#include "Scheduler.h"
+
+#define SETTINGS_STORE_MAX_KEYS 16
+#define SETTINGS_STORE_RECORD_SIZE 10
+
+namespace samduino
+{
+
+struct SettingsStoreConfig
+{
+    // The region of EEPROM to use. It should hold a good number more
+    // records than there are keys, since every spare record spreads
+    // the wear further.
+    uint16_t Base;
+    uint16_t Size;
+
+    // How often to check for new settings to write when idle.
+    unsigned long IdlePollMs;
+
+    SettingsStoreConfig()
+        : Base( 0 )
+        , Size( E2END + 1 )
+        , IdlePollMs( 50 )
+    {}
+};
+
+class SettingsStore : public ScheduledWork
+{
+public:
+    // Constructing the store scans the region to recover the settings.
+    explicit SettingsStore( const SettingsStoreConfig& );
+
+    // Get reads the current value of a setting. It returns false if
+    // the key has never been set.
+    bool Get( uint8_t key, uint32_t& value ) const;
+
+    // Set changes a setting, which will be written in the background.
+    // It returns false for key 0xFF or when there is no room for
+    // another key.
+    bool Set( uint8_t key, uint32_t value );
+
+    // IsIdle returns true when every setting has been written.
+    bool IsIdle() const;
+
+    unsigned long DoWork( unsigned long now ) override;
+
+private:
+    struct Entry
+    {
+        uint32_t Seq;
+        uint32_t Value;
+        uint16_t Slot;
+        uint8_t Key;
+        uint8_t Dirty;
+    };
+
+    Entry* Find( uint8_t key );
+    const Entry* Find( uint8_t key ) const;
+    bool IsLive( uint16_t slot ) const;
+    void Recover();
+    void StartWrite( Entry& );
+
+    const SettingsStoreConfig m_config;
+    const uint16_t m_numSlots;
+
+    Entry m_entries[SETTINGS_STORE_MAX_KEYS];
+    uint8_t m_numEntries;
+
+    uint32_t m_nextSeq;
+    uint16_t m_head;
+
+    // The record being written, if m_writing
+    uint8_t m_record[SETTINGS_STORE_RECORD_SIZE];
+    uint8_t m_writing;
+    uint8_t m_offset;
+    uint8_t m_writeKey;
+    uint16_t m_writeSlot;
+};
+
+} // samduino
+
+#endif // c++
+
+#endif
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ArduinoTestState.h"
+#include "Crc8.h"
+#include "SettingsStore.h"
+
+using namespace samduino;
+
+namespace
+{
+
+class SettingsStoreTest : public ::testing::Test
+{
+public:
+    SettingsStoreTest()
+    {
+        char path[] = "/tmp/samduino-eeprom-XXXXXX";
+        const int fd = ::mkstemp( path );
+        ::close( fd );
+        m_path = path;
+
+        m_state.SetTimeProvider( &m_time );
+        Reboot();
+    }
+
+    virtual ~SettingsStoreTest()
+    {
+        m_state.SetEepromProvider( nullptr );
+        m_eeprom.reset();
+        ::unlink( m_path.c_str() );
+    }
+
+protected:
+
+    // Reboot starts over with a new device over the same file.
+    void Reboot()
+    {
+        m_eeprom.reset();
+        m_eeprom.reset( new FileEepromProvider( m_path, E2END + 1, m_time ) );
+        m_state.SetEepromProvider( m_eeprom.get() );
+    }
+
+    // Flush runs the store on 1ms ticks until it has nothing to write.
+    void Flush( SettingsStore& store )
+    {
+        while ( !store.IsIdle() )
+        {
+            m_time.Advance( 1000 );
+            store.DoWork( millis() );
+        }
+
+        // And let the last byte finish
+        m_time.Advance( 4000 );
+    }
+
+    std::string m_path;
+    VirtualTimeProvider m_time;
+    ArduinoTestState m_state;
+    std::unique_ptr< FileEepromProvider > m_eeprom;
+    SettingsStoreConfig m_config;
+};
+
+}
+
+TEST_F( SettingsStoreTest, RecoversAfterReboot )
+{
+    {
+        SettingsStore store( m_config );
+        uint32_t value;
+        EXPECT_FALSE( store.Get( 1, value ) );
+
+        EXPECT_TRUE( store.Set( 1, 1234 ) );
+        EXPECT_TRUE( store.Set( 2, 0xDEADBEEF ) );
+        EXPECT_TRUE( store.Set( 1, 5678 ) );
+        EXPECT_FALSE( store.Set( 0xFF, 1 ) );
+
+        // Readable right away
+        EXPECT_TRUE( store.Get( 1, value ) );
+        EXPECT_EQ( 5678, value );
+
+        Flush( store );
+    }
+
+    Reboot();
+    SettingsStore store( m_config );
+
+    uint32_t value = 0;
+    EXPECT_TRUE( store.Get( 1, value ) );
+    EXPECT_EQ( 5678, value );
+    EXPECT_TRUE( store.Get( 2, value ) );
+    EXPECT_EQ( 0xDEADBEEF, value );
+}
+
+TEST_F( SettingsStoreTest, NeverBlocksAndLevelsWear )
+{
+    const uint32_t kUpdates = 1000;
+
+    SettingsStore store( m_config );
+    store.Set( 7, 42 );
+    Flush( store );
+
+    const size_t before = m_eeprom->Writes();
+    for ( uint32_t i = 0; i < kUpdates; i++ )
+    {
+        store.Set( 1, i );
+        Flush( store );
+    }
+
+    // Writing in place would wear the same 4 bytes kUpdates times.
+    // Spread over the 101 free records each byte sees about a hundredth.
+    EXPECT_EQ( 0, m_eeprom->BlockedMicros() );
+    EXPECT_LE( m_eeprom->MaxWear(), kUpdates / 100 + 1 );
+
+    // A 4 byte value costs a 10 byte record, less what is unchanged.
+    const double amplification = static_cast< double >( m_eeprom->Writes() - before ) / ( kUpdates * 4 );
+    EXPECT_LE( amplification, 2.5 );
+    RecordProperty( "WriteAmplification", std::to_string( amplification ) );
+
+    // And the key that never changed survived all of it.
+    Reboot();
+    SettingsStore rebooted( m_config );
+    uint32_t value = 0;
+    EXPECT_TRUE( rebooted.Get( 7, value ) );
+    EXPECT_EQ( 42, value );
+    EXPECT_TRUE( rebooted.Get( 1, value ) );
+    EXPECT_EQ( kUpdates - 1, value );
+}
+
+TEST_F( SettingsStoreTest, SurvivesPowerLossMidWrite )
+{
+    {
+        SettingsStore store( m_config );
+        store.Set( 3, 100 );
+        Flush( store );
+
+        // Lose power after the sequence number, the key and two bytes of
+        // the value of the next record.
+        m_eeprom->CutPowerAfter( 7 );
+        store.Set( 3, 200 );
+        Flush( store );
+    }
+
+    Reboot();
+
+    // The torn record looks like a live one for key 3, so only its crc8
+    // can give it away.
+    uint8_t torn[SETTINGS_STORE_RECORD_SIZE];
+    for ( uint8_t i = 0; i < SETTINGS_STORE_RECORD_SIZE; i++ )
+    {
+        torn[i] = eeprom_read_byte( reinterpret_cast< uint8_t* >( SETTINGS_STORE_RECORD_SIZE + i ) );
+    }
+    EXPECT_EQ( 1, torn[0] );
+    EXPECT_EQ( 3, torn[4] );
+    EXPECT_EQ( 200, torn[5] );
+    EXPECT_NE( static_cast< uint8_t >( ~Crc8( torn, SETTINGS_STORE_RECORD_SIZE - 1 ) ),
+               torn[SETTINGS_STORE_RECORD_SIZE - 1] );
+
+    {
+        SettingsStore store( m_config );
+        uint32_t value = 0;
+        EXPECT_TRUE( store.Get( 3, value ) );
+        EXPECT_EQ( 100, value );
+
+        // And writing carries on from there
+        store.Set( 3, 300 );
+        Flush( store );
+    }
+
+    Reboot();
+    SettingsStore store( m_config );
+    uint32_t value = 0;
+    EXPECT_TRUE( store.Get( 3, value ) );
+    EXPECT_EQ( 300, value );
+}
+
+TEST_F( SettingsStoreTest, StartsEmptyOnZeroedEeprom )
+{
+    // As left by the eeprom_clear example sketch
+    m_state.SetEepromProvider( nullptr );
+    m_eeprom.reset();
+    ASSERT_EQ( 0, ::truncate( m_path.c_str(), 0 ) );
+    ASSERT_EQ( 0, ::truncate( m_path.c_str(), E2END + 1 ) );
+    Reboot();
+
+    {
+        // Every record of 0's has a good crc8, but not a good check byte
+        SettingsStore store( m_config );
+        uint32_t value = 1;
+        EXPECT_FALSE( store.Get( 0, value ) );
+
+        store.Set( 0, 5 );
+        Flush( store );
+    }
+
+    Reboot();
+    SettingsStore store( m_config );
+    uint32_t value = 0;
+    EXPECT_TRUE( store.Get( 0, value ) );
+    EXPECT_EQ( 5, value );
+}
+
+TEST_F( SettingsStoreTest, BootScanCost )
+{
+    CallCosts costs = CallCosts::Uno();
+    m_state.SetCallCosts( &costs );
+
+    const unsigned long long start = m_time.NowNs();
+    SettingsStore store( m_config );
+    const unsigned long long took = m_time.NowNs() - start;
+
+    // Every byte of the 102 records is read once.
+    EXPECT_EQ( 102 * SETTINGS_STORE_RECORD_SIZE * costs.EepromReadNs, took );
+}
@@ -1,5 +1,7 @@
 #include "SevenSegment.h"
 #include "Arduino.h"
+#include "HardwareTimer.h"
+#include "Keypad.h"
 #include "Scheduler.h"
 
 namespace samduino
@@ -18,10 +20,49 @@ const uint8_t kDigit6 = 0xBE;   // 1011 1110
 const uint8_t kDigit7 = 0xE0;   // 1110 0000
 const uint8_t kDigit8 = 0xFE;   // 1111 1110
 const uint8_t kDigit9 = 0xF6;   // 1111 0110
+
+// No digit index can be this since NumD is at most 255.
+const uint8_t kUnknownSelected = 0xFF;
+
+// Each digit is shown for 5ms unless SetFrameMillis() says otherwise.
+const unsigned long kDefaultStepUs = 5000;
+}
+
+SevenSegmentFrame::SevenSegmentFrame( uint8_t* first, uint8_t* second )
+    : m_front( 0 )
+    , m_showing( 0 )
+{
+    m_buffers[0] = first;
+    m_buffers[1] = second;
 }
 
+uint8_t* SevenSegmentFrame::Back()
+{
+    const uint8_t front = m_front;
+    if ( m_showing != front )
+    {
+        return nullptr;
+    }
+
+    return m_buffers[front ^ 1];
+}
+
+void SevenSegmentFrame::Publish()
+{
+    m_front = m_front ^ 1;
+}
+
+const uint8_t* SevenSegmentFrame::Latch()
+{
+    m_showing = m_front;
+    return m_buffers[m_showing];
+}
+
+////////////////
+
 SevenSegment::SevenSegment( SevenSegmentState& state )
     : m_state( state )
+    , m_selected( kUnknownSelected )
 {
     const uint8_t* pins = &m_state.PinA;
     for ( uint8_t i = 0; i < 8; i++ )
@@ -40,12 +81,20 @@ SevenSegment::SevenSegment( SevenSegmentState& state )
     }
 }
 
-void SevenSegment::Display( uint8_t which )
+void SevenSegment::Blank()
 {
-    // Pull them all up so they are off while we change
-    // Pull down the selection pin (this enables it)
-    if ( m_state.DPins )
+    if ( !m_state.DPins )
     {
+        return;
+    }
+
+    if ( m_selected < m_state.NumD )
+    {
+        digitalWrite( m_state.DPins[m_selected], HIGH );
+    }
+    else if ( m_selected == kUnknownSelected )
+    {
+        // Pull them all up since we don't know who is on
         for ( uint8_t i = 0; i < m_state.NumD; i++ )
         {
             const uint8_t pin = m_state.DPins[i];
@@ -53,16 +102,30 @@ void SevenSegment::Display( uint8_t which )
         }
     }
 
+    m_selected = m_state.NumD;
+}
+
+void SevenSegment::Display( uint8_t which )
+{
+    // Pull up the selected digit so it is off while we change
+    Blank();
+
+    const uint8_t* dBits = m_state.DBits;
+    if ( m_state.Frame )
+    {
+        dBits = which == 0 ? m_state.Frame->Latch() : m_state.Frame->Showing();
+    }
+
     // And then set the 7 segment to the bits requested
-    if ( m_state.DBits )
+    if ( dBits )
     {
         const uint8_t* pins = &m_state.PinA;
         uint8_t mask = SEVEN_SEGMENT_BIT_A_MASK;
+        const uint8_t bits = dBits[which];
 
         for ( uint8_t i = 0; i < 8; i++, mask = mask >> 1 )
         {
             const uint8_t pin = pins[i];
-            const uint8_t bits = m_state.DBits[which];
 
             const uint8_t val = ( bits & mask ) ? HIGH : LOW;
             digitalWrite( pin, val );
@@ -73,6 +136,7 @@ void SevenSegment::Display( uint8_t which )
     if ( m_state.DPins && which < m_state.NumD )
     {
         digitalWrite( m_state.DPins[which], LOW );
+        m_selected = which;
     }
 }
 
@@ -136,11 +200,30 @@ uint8_t SevenSegment::MakeBits( uint8_t value, Dotted dotted )
     return result;
 }
 
-void SevenSegment::SetError()
+uint8_t* SevenSegment::Compose()
 {
-    if ( !m_state.DBits )
+    if ( m_state.Frame )
     {
-        return;
+        return m_state.Frame->Back();
+    }
+
+    return m_state.DBits;
+}
+
+void SevenSegment::Publish()
+{
+    if ( m_state.Frame )
+    {
+        m_state.Frame->Publish();
+    }
+}
+
+bool SevenSegment::SetError()
+{
+    uint8_t* dBits = Compose();
+    if ( !dBits )
+    {
+        return false;
     }
 
     for ( uint8_t i = 0; i < m_state.NumD; i++ )
@@ -148,44 +231,180 @@ void SevenSegment::SetError()
         switch ( i )
         {
         case 0:
-            m_state.DBits[i] = MakeBits( 'E' );
+            dBits[i] = MakeBits( 'E' );
             break;
         case 1:
         case 2:
         case 4:
-            m_state.DBits[i] = MakeBits( 'r' );
+            dBits[i] = MakeBits( 'r' );
             break;
         case 3:
-            m_state.DBits[i] = MakeBits( 'o' );
+            dBits[i] = MakeBits( 'o' );
             break;
         default:
-            m_state.DBits[i] = MakeBits( ' ' );
+            dBits[i] = MakeBits( ' ' );
             break;
         }
     }
+
+    Publish();
+    return true;
 }
 
 
 ////////////////
 
 SevenSegmentDisplayWork::SevenSegmentDisplayWork( SevenSegment& seven )
-    : m_7( seven )
-    , m_nextRun( 0 )
+    : m_single( &seven )
+    , m_displays( &m_single )
+    , m_numDisplays( 1 )
+    , m_numSlots( 0 )
     , m_which( 0 )
-{}
+    , m_keypad( nullptr )
+    , m_stepMs( 0 )
+    , m_stepUs( 0 )
+{
+    CountSlots();
+    SetStepMicros( kDefaultStepUs );
+}
 
-unsigned long SevenSegmentDisplayWork::DueAtMillis()
+SevenSegmentDisplayWork::SevenSegmentDisplayWork( SevenSegment** displays, uint8_t numDisplays )
+    : m_single( nullptr )
+    , m_displays( displays )
+    , m_numDisplays( numDisplays )
+    , m_numSlots( 0 )
+    , m_which( 0 )
+    , m_keypad( nullptr )
+    , m_stepMs( 0 )
+    , m_stepUs( 0 )
 {
-    return m_nextRun;
+    CountSlots();
+    SetStepMicros( kDefaultStepUs );
 }
 
-void SevenSegmentDisplayWork::DoWork()
+void SevenSegmentDisplayWork::CountSlots()
 {
-    uint8_t which = ( m_which + 1 ) % m_7.State().NumD;
-    m_7.Display( which );
+    // The schedule has a step for each digit of the largest display.
+    m_numSlots = 0;
+    for ( uint8_t i = 0; i < m_numDisplays; i++ )
+    {
+        if ( m_displays[i]->State().NumD > m_numSlots )
+        {
+            m_numSlots = m_displays[i]->State().NumD;
+        }
+    }
+}
+
+void SevenSegmentDisplayWork::SetFrameMillis( unsigned long frameMs )
+{
+    CountSlots();
+    SetStepMicros( frameMs * 1000 / ( m_numSlots ? m_numSlots : 1 ) );
+
+#ifdef attachTimerInterrupt
+    if ( s_timerWork == this )
+    {
+        attachTimerInterrupt( m_stepUs, &SevenSegmentDisplayWork::TimerIsr );
+    }
+#endif
+}
+
+void SevenSegmentDisplayWork::SetStepMicros( unsigned long stepUs )
+{
+    m_stepUs = stepUs;
+    if ( m_stepUs == 0 )
+    {
+        m_stepUs = 1;
+    }
+
+    m_stepMs = m_stepUs / 1000;
+    if ( m_stepMs == 0 )
+    {
+        m_stepMs = 1;
+    }
+}
+
+bool SevenSegmentDisplayWork::AttachKeypad( Keypad& keypad )
+{
+    if ( keypad.NumRows() > m_numSlots )
+    {
+        return false;
+    }
+
+    m_keypad = &keypad;
+    return true;
+}
+
+unsigned long SevenSegmentDisplayWork::DoWork( unsigned long now )
+{
+    Step();
+    return now + m_stepMs;
+}
+
+void SevenSegmentDisplayWork::Step()
+{
+    if ( m_numSlots == 0 )
+    {
+        return;
+    }
+
+    uint8_t which = ( m_which + 1 ) % m_numSlots;
+
+    // Each display has its own segment lines, so lighting digit `which`
+    // on all of them at once is fine.
+    for ( uint8_t i = 0; i < m_numDisplays; i++ )
+    {
+        SevenSegment& seven = *m_displays[i];
+        if ( which < seven.State().NumD )
+        {
+            seven.Display( which );
+        }
+        else
+        {
+            seven.Blank();
+        }
+    }
+
+    // The selected digit is also the keypad row being driven
+    if ( m_keypad )
+    {
+        m_keypad->ScanRow( which );
+    }
 
     m_which = which;
-    m_nextRun = millis() + 5;
 }
 
+#ifdef attachTimerInterrupt
+
+SevenSegmentDisplayWork* SevenSegmentDisplayWork::s_timerWork = nullptr;
+
+void SevenSegmentDisplayWork::TimerIsr()
+{
+    if ( s_timerWork )
+    {
+        s_timerWork->Step();
+    }
+}
+
+bool SevenSegmentDisplayWork::StartTimerRefresh()
+{
+    if ( !attachTimerInterrupt( m_stepUs, &SevenSegmentDisplayWork::TimerIsr ) )
+    {
+        return false;
+    }
+
+    s_timerWork = this;
+    return true;
+}
+
+void SevenSegmentDisplayWork::StopTimerRefresh()
+{
+    if ( s_timerWork == this )
+    {
+        detachTimerInterrupt();
+        s_timerWork = nullptr;
+    }
+}
+
+#endif // attachTimerInterrupt
+
 } // samduino
@@ -24,6 +24,7 @@
  */
 
 #include "Arduino.h"
+#include "HardwareTimer.h"
 #include "Scheduler.h"
 
 #define SEVEN_SEGMENT_BIT_A_MASK 0x80
@@ -40,6 +41,51 @@
 namespace samduino
 {
 
+class Keypad;
+
+/**
+ * SevenSegmentFrame double-buffers the digit bitmaps so that a
+ * producer never changes a frame while it is being shown, even when
+ * the display is refreshed from an interrupt.
+ *
+ * The producer composes into Back() and then Publish()es it, which
+ * just flips the front index. The refresh Latch()es the front at the
+ * start of each scan of the digits and shows that buffer for the whole
+ * scan. Back() is unavailable (nullptr) from a Publish() until the
+ * refresh has latched it, since until then the old front may still be
+ * on screen.
+ *
+ * Each index is a single byte written by only one side, so neither
+ * side needs to disable interrupts, and nothing is copied.
+ */
+class SevenSegmentFrame
+{
+public:
+    // Both buffers should be NumD-sized arrays.
+    SevenSegmentFrame( uint8_t* first, uint8_t* second );
+    SevenSegmentFrame( const SevenSegmentFrame& ) = delete;
+
+    // Back returns the buffer to compose the next frame into, or
+    // nullptr when the last published frame hasn't been latched yet.
+    uint8_t* Back();
+
+    // Publish makes the back buffer the front.
+    void Publish();
+
+    // Latch is used by the refresh to pick up the latest front.
+    const uint8_t* Latch();
+
+    // Showing returns the buffer latched by the refresh.
+    const uint8_t* Showing() const { return m_buffers[m_showing]; }
+
+private:
+    uint8_t* m_buffers[2];
+    // Written only by Publish()
+    volatile uint8_t m_front;
+    // Written only by Latch()
+    volatile uint8_t m_showing;
+};
+
 /**
  * A configuration and state structure that is setup to
  * describe how you have wired your device.
@@ -48,6 +94,8 @@ namespace samduino
  * For single-digit devices, NumD should still be set to `1`
  * and DBits should be an array of one. DPins can be set to
  * `nullptr` when there are no digit selection pins.
+ *
+ * To double-buffer the digits, set Frame instead of DBits.
  */
 struct SevenSegmentState
 {
@@ -68,11 +116,14 @@ struct SevenSegmentState
     // Should be set to a NumD-sized array of places
     // to hold the current value as a bitmap.
     uint8_t* DBits;
+    // Or, a double-buffered pair of them.
+    SevenSegmentFrame* Frame;
 
     SevenSegmentState()
         : NumD( 0 )
         , DPins( 0 )
         , DBits( 0 )
+        , Frame( 0 )
     {}
 };
 
@@ -91,15 +142,34 @@ class SevenSegment
 public:
     explicit SevenSegment( SevenSegmentState& );
 
+    // Display lights digit `which`. Only the previously selected digit is
+    // turned off first, so the cost does not grow with NumD.
+    // With a Frame, showing digit 0 latches the latest published frame.
     void Display( uint8_t which );
+
+    // Blank turns off whichever digit is selected.
+    void Blank();
+
     SevenSegmentState& State() { return m_state; }
 
     static uint8_t MakeBits( uint8_t value, Dotted dotted = Dotted::kWithoutDot );
 
-    void SetError();
+    // Compose returns where to write the digits: DBits, or the back of
+    // the Frame. It returns nullptr when there is nowhere to write yet.
+    uint8_t* Compose();
+
+    // Publish shows what was written to Compose(). Without a Frame the
+    // digits were written in place and there is nothing to do.
+    void Publish();
+
+    // SetError shows "Error". It returns false if it couldn't be
+    // composed yet.
+    bool SetError();
 
 private:
     SevenSegmentState& m_state;
+    // The digit currently selected, or kUnknownSelected when any might be.
+    uint8_t m_selected;
 };
 
 /**
@@ -108,18 +178,79 @@ private:
  * values on a multi-digit 7-segment LED display. It schedules
  * the repeated selection of which digit to display and cycles
  * fast enough for the eye to think all digits are on.
+ *
+ * It can also drive several displays (such as chained 4-digit modules),
+ * each with its own segment pins. The displays are stepped together, so
+ * digit N of every display is lit at the same time and the duty cycle of
+ * each digit depends only on the largest NumD, not on how many displays
+ * there are. Displays with fewer digits are blanked for the extra steps
+ * so all digits are equally bright.
+ *
+ * Instead of adding it to a Scheduler, it can StartTimerRefresh() to step
+ * from a timer interrupt. Then the refresh keeps exact time no matter
+ * how long other work runs. This is only available where
+ * attachTimerInterrupt() is (see HardwareTimer.h), and on AVR the sketch
+ * must include HardwareTimerIsr.h.
+ *
+ * It can also scan a Keypad whose rows are wired to the digit-select
+ * pins: with a Keypad attached, each step reads row N of the keypad
+ * while digit N is lit.
  */
 class SevenSegmentDisplayWork : public ScheduledWork
 {
 public:
     explicit SevenSegmentDisplayWork( SevenSegment& );
-    unsigned long DueAtMillis() override;
-    void DoWork() override;
+
+    // The `displays` array is not copied and must outlive this work.
+    SevenSegmentDisplayWork( SevenSegment** displays, uint8_t numDisplays );
+
+    unsigned long DoWork( unsigned long now ) override;
+
+    // SetFrameMillis sets how long it should take to show every digit
+    // once. By default each digit is shown for 5ms however many there
+    // are. When scheduled, each digit is shown for at least 1ms
+    // regardless. A running timer refresh is restarted at the new rate.
+    void SetFrameMillis( unsigned long frameMs );
+
+    // Step shows the next digit of every display.
+    void Step();
+
+#ifdef attachTimerInterrupt
+    // StartTimerRefresh attaches Step() to the timer interrupt. Only one
+    // SevenSegmentDisplayWork can use the timer at a time, and it must
+    // not also be added to a Scheduler. It returns false if there is no
+    // timer to attach to, such as when an AVR sketch doesn't include
+    // HardwareTimerIsr.h.
+    bool StartTimerRefresh();
+    void StopTimerRefresh();
+#endif
+
+    // AttachKeypad scans `keypad` along with the digits. Its rows must be
+    // the digit-select pins in order, and it must not also be added to a
+    // Scheduler. It returns false, attaching nothing, if the keypad has
+    // more rows than there are digits, as the last rows would never be
+    // scanned.
+    bool AttachKeypad( Keypad& keypad );
 
 private:
-    SevenSegment& m_7;
-    unsigned long m_nextRun;
+#ifdef attachTimerInterrupt
+    static void TimerIsr();
+    static SevenSegmentDisplayWork* s_timerWork;
+#endif
+
+    void CountSlots();
+    void SetStepMicros( unsigned long stepUs );
+
+    // With a single display, m_displays points here, so every step can
+    // treat it as an array of one.
+    SevenSegment* m_single;
+    SevenSegment** m_displays;
+    uint8_t m_numDisplays;
+    uint8_t m_numSlots;
     uint8_t m_which;
+    Keypad* m_keypad;
+    unsigned long m_stepMs;
+    unsigned long m_stepUs;
 };
 
 } // samduino
@@ -2,6 +2,7 @@
 
 #include "ArduinoTestState.h"
 #include "SevenSegment.h"
+#include "WorkProfiler.h"
 
 using namespace samduino;
 
@@ -80,3 +81,256 @@ TEST_F( SevenSegmentTest, Display_109_1 )
     EXPECT_EQ( LOW, m_io.ReadState( m_layout.PinA ).value );
     EXPECT_EQ( LOW, m_io.ReadState( m_layout.PinDot ).value );
 }
+
+namespace
+{
+
+// Stands in for a sensor read in the thermometer.
+class SensorWork : public ScheduledWork
+{
+public:
+    unsigned long DoWork( unsigned long now ) override
+    {
+        analogRead( 0 );
+        return now + 100;
+    }
+};
+
+}
+
+TEST_F( SevenSegmentTest, PredictsRefreshOnTarget )
+{
+    VirtualTimeProvider time;
+    CallCosts costs = CallCosts::Uno();
+    m_state.SetTimeProvider( &time ).SetCallCosts( &costs );
+    m_io.WriteAnalog( 0, 512 );
+
+    SevenSegment seven( m_layout );
+    SevenSegmentDisplayWork display( seven );
+    SensorWork sensor;
+
+    ProfiledWork profiledDisplay( display, time );
+    ProfiledWork profiledSensor( sensor, time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+
+    Scheduler scheduler( config );
+    scheduler.AddWork( profiledDisplay );
+    scheduler.AddWork( profiledSensor );
+
+    const unsigned long long start = time.NowNs();
+    time.SetDelayHook( [&]() {
+        if ( time.NowNs() - start >= 1000000000ULL )
+        {
+            scheduler.Stop();
+        }
+    });
+    scheduler.Loop();
+    const unsigned long long elapsed = time.NowNs() - start;
+
+    // 10 digitalWrite()s per digit: 1 deselect, 8 segments, 1 select.
+    EXPECT_NEAR( 10 * costs.DigitalWriteNs / 1000.0, profiledDisplay.AverageUs(), 0.1 );
+
+    // One digit every 5ms, so each of the 4 digits refreshes at 50Hz.
+    EXPECT_NEAR( 50.0, profiledDisplay.CallsPerSecond( elapsed ) / m_layout.NumD, 0.5 );
+    EXPECT_LT( profiledDisplay.Budget( elapsed ), 0.01 );
+
+    EXPECT_EQ( costs.AnalogReadNs, profiledSensor.MaxNs() );
+    EXPECT_NEAR( 10.0, profiledSensor.CallsPerSecond( elapsed ), 0.1 );
+}
+
+TEST_F( SevenSegmentTest, MultiplexesSeveralDisplaysTogether )
+{
+    // A second, 10-digit display with its own segment lines.
+    uint8_t dPins[10];
+    uint8_t dBits[10];
+    SevenSegmentState wide;
+    wide.PinA = 20;
+    wide.PinB = 21;
+    wide.PinC = 22;
+    wide.PinD = 23;
+    wide.PinE = 24;
+    wide.PinF = 25;
+    wide.PinG = 26;
+    wide.PinDot = 27;
+    wide.NumD = 10;
+    wide.DPins = dPins;
+    wide.DBits = dBits;
+
+    for ( uint8_t i = 0; i < wide.NumD; i++ )
+    {
+        dPins[i] = 30 + i;
+        dBits[i] = SevenSegment::MakeBits( i );
+    }
+
+    for ( uint8_t i = 0; i < m_layout.NumD; i++ )
+    {
+        m_DBits[i] = SevenSegment::MakeBits( 8 );
+    }
+
+    SevenSegment narrow( m_layout );
+    SevenSegment seven( wide );
+    SevenSegment* displays[2] = { &narrow, &seven };
+
+    SevenSegmentDisplayWork display( displays, 2 );
+
+    // Each digit is shown for 5ms by default, however many there are.
+    EXPECT_EQ( 105, display.DoWork( 100 ) );
+
+    // A 20ms frame over 10 digits steps every 2ms.
+    display.SetFrameMillis( 20 );
+    EXPECT_EQ( 102, display.DoWork( 100 ) );
+
+    // Those two steps showed digits 1 and 2.
+    for ( uint8_t step = 0; step < 25; step++ )
+    {
+        const uint8_t which = ( step + 2 ) % wide.NumD;
+
+        // Exactly digit `which` is selected on the wide display...
+        for ( uint8_t i = 0; i < wide.NumD; i++ )
+        {
+            EXPECT_EQ( i == which ? LOW : HIGH, m_io.ReadState( dPins[i] ).value );
+        }
+        EXPECT_EQ( ( dBits[which] & SEVEN_SEGMENT_BIT_A_MASK ) ? HIGH : LOW,
+                   m_io.ReadState( wide.PinA ).value );
+
+        // ...and at the same time on the narrow one, which is blank once
+        // it runs out of digits.
+        for ( uint8_t i = 0; i < m_layout.NumD; i++ )
+        {
+            EXPECT_EQ( i == which ? LOW : HIGH, m_io.ReadState( m_DPins[i] ).value );
+        }
+
+        display.DoWork( 0 );
+    }
+}
+
+TEST_F( SevenSegmentTest, DoubleBufferedFrameNeverTears )
+{
+    uint8_t first[4];
+    uint8_t second[4];
+    SevenSegmentFrame frame( first, second );
+    m_layout.DBits = nullptr;
+    m_layout.Frame = &frame;
+
+    SevenSegment seven( m_layout );
+
+    // Shows the a segment of digit `which`
+    auto segmentA = [&]( uint8_t which ) {
+        seven.Display( which );
+        return m_io.ReadState( m_layout.PinA ).value;
+    };
+
+    // Compose "1 0 1 0" and show its first digit
+    uint8_t* back = seven.Compose();
+    ASSERT_NE( nullptr, back );
+    for ( uint8_t i = 0; i < 4; i++ )
+    {
+        back[i] = SevenSegment::MakeBits( i % 2 ? 0 : 1 );
+    }
+    seven.Publish();
+    EXPECT_EQ( LOW, segmentA( 0 ) );
+
+    // Compose "0 1 0 1" part way through the scan
+    back = seven.Compose();
+    ASSERT_NE( nullptr, back );
+    for ( uint8_t i = 0; i < 4; i++ )
+    {
+        back[i] = SevenSegment::MakeBits( i % 2 ? 1 : 0 );
+    }
+    EXPECT_EQ( HIGH, segmentA( 1 ) );
+    seven.Publish();
+
+    // The rest of the scan is still the first frame, and the old front
+    // can't be written to until the new one is picked up.
+    EXPECT_EQ( LOW, segmentA( 2 ) );
+    EXPECT_EQ( HIGH, segmentA( 3 ) );
+    EXPECT_EQ( nullptr, seven.Compose() );
+    EXPECT_FALSE( seven.SetError() );
+
+    // The next scan shows the second frame
+    EXPECT_EQ( HIGH, segmentA( 0 ) );
+    EXPECT_EQ( LOW, segmentA( 1 ) );
+    EXPECT_EQ( second, seven.Compose() );
+}
+
+namespace
+{
+
+// Hogs the loop for 50ms out of every 100ms.
+class HogWork : public ScheduledWork
+{
+public:
+    unsigned long DoWork( unsigned long now ) override
+    {
+        delayMicroseconds( 50000 );
+        return now + 100;
+    }
+};
+
+}
+
+TEST_F( SevenSegmentTest, TimerRefreshIgnoresLongWork )
+{
+    VirtualTimeProvider time;
+    m_state.SetTimeProvider( &time );
+
+    for ( uint8_t i = 0; i < 4; i++ )
+    {
+        m_DBits[i] = SevenSegment::MakeBits( i );
+    }
+
+    SevenSegment seven( m_layout );
+    SevenSegmentDisplayWork display( seven );
+    ASSERT_TRUE( display.StartTimerRefresh() );
+
+    HogWork hog;
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+    Scheduler scheduler( config );
+    scheduler.AddWork( hog );
+
+    time.SetDelayHook( [&]() {
+        if ( time.NowNs() >= 1000000000ULL )
+        {
+            scheduler.Stop();
+        }
+    });
+    scheduler.Loop();
+    display.StopTimerRefresh();
+
+    // A step every 5ms on the dot, hog or not.
+    const size_t fires = time.TimerFires();
+    EXPECT_EQ( time.NowNs() / 5000000, fires );
+
+    const uint8_t which = fires % 4;
+    for ( uint8_t i = 0; i < 4; i++ )
+    {
+        EXPECT_EQ( i == which ? LOW : HIGH, m_io.ReadState( m_DPins[i] ).value );
+    }
+
+    // And no more once stopped
+    time.Advance( 100000 );
+    EXPECT_EQ( fires, time.TimerFires() );
+}
+
+TEST_F( SevenSegmentTest, TimerRefreshFollowsTheFrameRate )
+{
+    VirtualTimeProvider time;
+    m_state.SetTimeProvider( &time );
+
+    SevenSegment seven( m_layout );
+    SevenSegmentDisplayWork display( seven );
+    ASSERT_TRUE( display.StartTimerRefresh() );
+
+    time.Advance( 20000 );
+    EXPECT_EQ( 4u, time.TimerFires() );
+
+    // 4 digits in 8ms is a step every 2ms from now on
+    display.SetFrameMillis( 8 );
+    time.Advance( 20000 );
+    EXPECT_EQ( 4u + 10, time.TimerFires() );
+
+    display.StopTimerRefresh();
+}
@@ -0,0 +1,187 @@
+#include "SoftPwm.h"
+#include "Arduino.h"
+
+namespace samduino
+{
+
+namespace
+{
+
+// No port slot can be this since there are at most SOFT_PWM_MAX_PORTS.
+const uint8_t kNoPort = 0xFF;
+
+}
+
+SoftPwm::SoftPwm( const SoftPwmConfig& config )
+    : m_config( config )
+    , m_numPins( config.NumPins < SOFT_PWM_MAX_PINS ? config.NumPins : SOFT_PWM_MAX_PINS )
+    , m_bits( config.Bits < 1 ? 1 : config.Bits > SOFT_PWM_MAX_BITS ? SOFT_PWM_MAX_BITS : config.Bits )
+    , m_maxLevel( static_cast< uint8_t >( ( 1U << m_bits ) - 1 ) )
+    , m_dirty( 0 )
+#ifdef portOutputRegister
+    , m_numPorts( 0 )
+#endif
+    , m_bit( 0 )
+    , m_started( 0 )
+    , m_dueAt( 0 )
+    , m_cycles( 0 )
+    , m_overruns( 0 )
+{
+    for ( uint8_t i = 0; i < m_numPins; i++ )
+    {
+        const uint8_t pin = m_config.Pins[i];
+        pinMode( pin, OUTPUT );
+        digitalWrite( pin, LOW );
+        m_levels[i] = 0;
+        m_latched[i] = 0;
+
+#ifdef portOutputRegister
+        // Find (or claim) the slot for this pin's port. Pins without a
+        // port, or beyond the ports we can track, use digitalWrite().
+        m_pinPorts[i] = kNoPort;
+        m_pinMasks[i] = 0;
+
+        const uint8_t port = digitalPinToPort( pin );
+        if ( port == NOT_A_PORT )
+        {
+            continue;
+        }
+
+        volatile uint8_t* reg = portOutputRegister( port );
+        uint8_t slot = 0;
+        while ( slot < m_numPorts && m_ports[slot] != reg )
+        {
+            slot++;
+        }
+
+        if ( slot == m_numPorts )
+        {
+            if ( m_numPorts == SOFT_PWM_MAX_PORTS )
+            {
+                continue;
+            }
+
+            m_ports[m_numPorts] = reg;
+            m_portMasks[m_numPorts] = 0;
+            m_numPorts++;
+        }
+
+        m_pinPorts[i] = slot;
+        m_pinMasks[i] = digitalPinToBitMask( pin );
+        m_portMasks[slot] |= m_pinMasks[i];
+#endif
+    }
+
+    Latch();
+}
+
+void SoftPwm::Set( uint8_t index, uint8_t level )
+{
+    if ( index >= m_numPins )
+    {
+        return;
+    }
+
+    if ( level > m_maxLevel )
+    {
+        level = m_maxLevel;
+    }
+
+    if ( m_levels[index] != level )
+    {
+        m_levels[index] = level;
+        m_dirty = 1;
+    }
+}
+
+void SoftPwm::Latch()
+{
+#ifdef portOutputRegister
+    for ( uint8_t bit = 0; bit < m_bits; bit++ )
+    {
+        for ( uint8_t slot = 0; slot < m_numPorts; slot++ )
+        {
+            m_slots[bit][slot] = 0;
+        }
+
+        for ( uint8_t i = 0; i < m_numPins; i++ )
+        {
+            if ( m_pinPorts[i] != kNoPort && ( m_levels[i] >> bit ) & 1 )
+            {
+                m_slots[bit][m_pinPorts[i]] |= m_pinMasks[i];
+            }
+        }
+    }
+#endif
+
+    for ( uint8_t i = 0; i < m_numPins; i++ )
+    {
+        m_latched[i] = m_levels[i];
+    }
+
+    m_dirty = 0;
+}
+
+void SoftPwm::Show( uint8_t bit )
+{
+#ifdef portOutputRegister
+    for ( uint8_t slot = 0; slot < m_numPorts; slot++ )
+    {
+        // The rest of the port may belong to someone writing it from
+        // an interrupt. Restoring SREG leaves interrupts as they were.
+        volatile uint8_t* reg = m_ports[slot];
+        const uint8_t sreg = SREG;
+        cli();
+        *reg = ( *reg & ~m_portMasks[slot] ) | m_slots[bit][slot];
+        SREG = sreg;
+    }
+#endif
+
+    for ( uint8_t i = 0; i < m_numPins; i++ )
+    {
+#ifdef portOutputRegister
+        if ( m_pinPorts[i] != kNoPort )
+        {
+            continue;
+        }
+#endif
+        digitalWrite( m_config.Pins[i], ( m_latched[i] >> bit ) & 1 ? HIGH : LOW );
+    }
+}
+
+unsigned long SoftPwm::DoWork( unsigned long now )
+{
+    const unsigned long length = m_config.UnitMs << m_bit;
+
+    // Keep to our own timeline so a late wake-up only shortens the next
+    // bit rather than stretching the cycle. Once a whole bit has been
+    // missed, start again from now.
+    if ( !m_started )
+    {
+        m_started = 1;
+        m_dueAt = now;
+    }
+    else if ( static_cast< long >( now - m_dueAt ) >= static_cast< long >( length ) )
+    {
+        m_overruns++;
+        m_dueAt = now;
+    }
+
+    if ( m_bit == 0 )
+    {
+        if ( m_dirty )
+        {
+            Latch();
+        }
+
+        m_cycles++;
+    }
+
+    Show( m_bit );
+
+    m_dueAt += length;
+    m_bit = ( m_bit + 1 ) % m_bits;
+    return m_dueAt;
+}
+
+} // samduino
@@ -0,0 +1,128 @@
+#ifndef Samduino_SoftPwm_h
+#define Samduino_SoftPwm_h
+
+/**
+ * SoftPwm dims a bank of pins which have no hardware PWM, such as LEDs
+ * or small heaters, using bit-angle modulation.
+ *
+ * Rather than switching each pin at its own point in every cycle, each
+ * bit of the levels is shown in turn for a time weighted by the bit:
+ * bit 0 for one UnitMs, bit 1 for two, bit 7 for 128. A level of L is
+ * then on for L units out of every (2^Bits - 1). The whole bank is
+ * updated together on each of those Bits wake-ups, so the work takes
+ * Bits wake-ups per cycle however many pins there are.
+ *
+ * Where the core provides portOutputRegister() the levels are kept as
+ * the value of each port for every bit, so a wake-up is one write per
+ * port. Otherwise, and for pins beyond SOFT_PWM_MAX_PORTS ports, each
+ * pin is written with digitalWrite().
+ *
+ * New levels take effect from the start of the next cycle, so a cycle
+ * never shows a mix of the bits of two levels.
+ */
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+#include "Arduino.h"
+#include "Scheduler.h"
+
+#define SOFT_PWM_MAX_PINS 16
+#define SOFT_PWM_MAX_PORTS 4
+#define SOFT_PWM_MAX_BITS 8
+
+namespace samduino
+{
+
+/**
+ * A configuration structure describing the pins of the bank.
+ * Pins and NumPins are required.
+ */
+struct SoftPwmConfig
+{
+    // A NumPins-sized array of the output pins
+    const uint8_t* Pins;
+    uint8_t NumPins;
+
+    // The levels go from 0 to 2^Bits - 1. At most SOFT_PWM_MAX_BITS.
+    uint8_t Bits;
+
+    // How long bit 0 is shown. A cycle takes (2^Bits - 1) * UnitMs, so
+    // the default is a 15ms (66Hz) cycle with 16 levels, which suits
+    // LEDs. A heater might use 8 bits of 4ms.
+    unsigned long UnitMs;
+
+    SoftPwmConfig()
+        : Pins( 0 )
+        , NumPins( 0 )
+        , Bits( 4 )
+        , UnitMs( 1 )
+    {}
+};
+
+class SoftPwm : public ScheduledWork
+{
+public:
+    // The pins are made outputs and start off.
+    explicit SoftPwm( const SoftPwmConfig& );
+
+    unsigned long DoWork( unsigned long now ) override;
+
+    // Set sets the level of the index'th pin from the next cycle on.
+    void Set( uint8_t index, uint8_t level );
+    uint8_t Get( uint8_t index ) const { return m_levels[index]; }
+
+    // MaxLevel is the level which is always on.
+    uint8_t MaxLevel() const { return m_maxLevel; }
+
+    // Cycles counts the cycles started.
+    unsigned long Cycles() const { return m_cycles; }
+
+    // Overruns counts the wake-ups which came a whole bit late. The
+    // previous bit was then shown for too long, and the cycle restarts
+    // its timing from the late bit.
+    unsigned long Overruns() const { return m_overruns; }
+
+private:
+    void Latch();
+    void Show( uint8_t bit );
+
+    const SoftPwmConfig m_config;
+    uint8_t m_numPins;
+    uint8_t m_bits;
+    uint8_t m_maxLevel;
+
+    // Set() writes the levels. They are latched at the start of a cycle.
+    uint8_t m_levels[SOFT_PWM_MAX_PINS];
+    uint8_t m_dirty;
+
+#ifdef portOutputRegister
+    // With port writes, the output register of each port and the value
+    // of its pins for each bit
+    volatile uint8_t* m_ports[SOFT_PWM_MAX_PORTS];
+    uint8_t m_portMasks[SOFT_PWM_MAX_PORTS];
+    uint8_t m_numPorts;
+    // Each pin's port slot, or kNoPort for pins written with
+    // digitalWrite(), and its bit of the port
+    uint8_t m_pinPorts[SOFT_PWM_MAX_PINS];
+    uint8_t m_pinMasks[SOFT_PWM_MAX_PINS];
+    uint8_t m_slots[SOFT_PWM_MAX_BITS][SOFT_PWM_MAX_PORTS];
+#endif
+    // The levels of the pins written with digitalWrite()
+    uint8_t m_latched[SOFT_PWM_MAX_PINS];
+
+    // The bit to show next, and when
+    uint8_t m_bit;
+    uint8_t m_started;
+    unsigned long m_dueAt;
+
+    unsigned long m_cycles;
+    unsigned long m_overruns;
+};
+
+} // samduino
+
+#endif // c++
+
+#endif
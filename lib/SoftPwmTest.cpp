@@ -0,0 +1,278 @@
+#include <gtest/gtest.h>
+
+#include "ArduinoTestState.h"
+#include "SoftPwm.h"
+#include "WorkProfiler.h"
+
+using namespace samduino;
+
+namespace
+{
+
+// The counter PWM SoftPwm replaces: a wake-up every unit which writes
+// every pin.
+class CounterPwm : public ScheduledWork
+{
+public:
+    CounterPwm( const uint8_t* pins, const uint8_t* levels, uint8_t numPins )
+        : m_pins( pins )
+        , m_levels( levels )
+        , m_numPins( numPins )
+        , m_count( 0 )
+    {}
+
+    unsigned long DoWork( unsigned long now ) override
+    {
+        for ( uint8_t i = 0; i < m_numPins; i++ )
+        {
+            digitalWrite( m_pins[i], m_count < m_levels[i] ? HIGH : LOW );
+        }
+
+        m_count = ( m_count + 1 ) % 255;
+        return now + 1;
+    }
+
+private:
+    const uint8_t* m_pins;
+    const uint8_t* m_levels;
+    const uint8_t m_numPins;
+    uint8_t m_count;
+};
+
+class SoftPwmTest : public ::testing::Test
+{
+public:
+    SoftPwmTest()
+    {
+        m_state.SetTimeProvider( &m_time )
+            .SetInputOutputProvider( &m_io );
+
+        // 16 pins over all three ports of an Uno
+        for ( uint8_t i = 0; i < 16; i++ )
+        {
+            m_pins[i] = i + 2;
+        }
+
+        m_config.Pins = m_pins;
+        m_config.NumPins = 16;
+        m_config.Bits = 8;
+        m_config.UnitMs = 1;
+    }
+
+protected:
+
+    // Run calls DoWork() exactly when asked for `cycles` cycles and
+    // returns how long each pin was HIGH, in ms.
+    std::vector< unsigned long > Run( SoftPwm& pwm, unsigned long cycles, size_t& calls )
+    {
+        std::vector< unsigned long > high( m_config.NumPins, 0 );
+        calls = 0;
+
+        const unsigned long start = millis();
+        const unsigned long end = start + cycles * pwm.MaxLevel() * m_config.UnitMs;
+        for ( unsigned long now = start; now < end; )
+        {
+            const unsigned long next = pwm.DoWork( now );
+            calls++;
+
+            for ( uint8_t i = 0; i < m_config.NumPins; i++ )
+            {
+                if ( m_io.ReadState( m_pins[i] ).value == HIGH )
+                {
+                    high[i] += next - now;
+                }
+            }
+
+            delay( next - now );
+            now = next;
+        }
+
+        return high;
+    }
+
+    VirtualTimeProvider m_time;
+    InMemoryInputOutputProvider m_io;
+    ArduinoTestState m_state;
+    uint8_t m_pins[16];
+    SoftPwmConfig m_config;
+};
+
+}
+
+TEST_F( SoftPwmTest, ShowsEveryLevelExactly )
+{
+    SoftPwm pwm( m_config );
+    EXPECT_EQ( 255, pwm.MaxLevel() );
+    for ( uint8_t i = 0; i < 16; i++ )
+    {
+        EXPECT_EQ( LOW, m_io.ReadState( m_pins[i] ).value );
+        pwm.Set( i, i * 17 );
+    }
+
+    // Every level over a whole number of cycles, with one wake-up per
+    // bit whatever the number of pins.
+    size_t calls;
+    const std::vector< unsigned long > high = Run( pwm, 4, calls );
+    EXPECT_EQ( 4u * 8, calls );
+    EXPECT_EQ( 4u, pwm.Cycles() );
+    EXPECT_EQ( 0u, pwm.Overruns() );
+    for ( uint8_t i = 0; i < 16; i++ )
+    {
+        EXPECT_EQ( 4u * i * 17, high[i] ) << "pin " << int( m_pins[i] );
+    }
+
+    // Levels beyond the bits are always on
+    pwm.Set( 0, 255 );
+    m_config.Bits = 4;
+    SoftPwm coarse( m_config );
+    coarse.Set( 3, 200 );
+    EXPECT_EQ( 15, coarse.Get( 3 ) );
+}
+
+TEST_F( SoftPwmTest, WritesPinsWithoutAPortOneByOne )
+{
+    CallCosts costs = CallCosts::Uno();
+    m_state.SetCallCosts( &costs );
+
+    // One pin on each port, and two with no port at all
+    const uint8_t pins[5] = { 2, 9, 14, 20, 21 };
+    for ( uint8_t i = 0; i < 5; i++ )
+    {
+        m_pins[i] = pins[i];
+    }
+    m_config.NumPins = 5;
+    SoftPwm pwm( m_config );
+    for ( uint8_t i = 0; i < 5; i++ )
+    {
+        pwm.Set( i, 50 * i + 1 );
+    }
+
+    const unsigned long long before = m_time.ChargedNs();
+    size_t calls;
+    const std::vector< unsigned long > high = Run( pwm, 2, calls );
+    for ( uint8_t i = 0; i < 5; i++ )
+    {
+        EXPECT_EQ( 2u * ( 50 * i + 1 ), high[i] ) << "pin " << int( m_pins[i] );
+    }
+
+    // Each wake-up is three port writes and two digitalWrite()s, on top
+    // of Run()'s millis()
+    const unsigned long long writeNs = 3 * costs.InterruptsNs;
+    const unsigned long long pwmNs = m_time.ChargedNs() - before - costs.MillisNs;
+    EXPECT_EQ( calls * ( 3 * writeNs + 2 * costs.DigitalWriteNs ), pwmNs );
+}
+
+TEST_F( SoftPwmTest, ChangesLevelOnlyBetweenCycles )
+{
+    m_config.NumPins = 1;
+    SoftPwm pwm( m_config );
+    pwm.Set( 0, 127 );
+
+    // Bits 0-6 are on for 127 units. Changing to 128 (only bit 7) half
+    // way through would show the whole cycle off, or on.
+    unsigned long now = millis();
+    for ( uint8_t bit = 0; bit < 4; bit++ )
+    {
+        now = pwm.DoWork( now );
+    }
+    pwm.Set( 0, 128 );
+
+    unsigned long high = 0;
+    for ( uint8_t bit = 4; bit < 8; bit++ )
+    {
+        const unsigned long next = pwm.DoWork( now );
+        if ( m_io.ReadState( m_pins[0] ).value == HIGH )
+        {
+            high += next - now;
+        }
+        now = next;
+    }
+    EXPECT_EQ( 16u + 32 + 64, high );
+
+    // The next cycle shows the new level
+    high = 0;
+    for ( uint8_t bit = 0; bit < 8; bit++ )
+    {
+        const unsigned long next = pwm.DoWork( now );
+        if ( m_io.ReadState( m_pins[0] ).value == HIGH )
+        {
+            high += next - now;
+        }
+        now = next;
+    }
+    EXPECT_EQ( 128u, high );
+
+    // Missing a whole bit restarts the timeline rather than cramming,
+    // and the late bit is still shown for its whole length
+    const unsigned long late = now + 10;
+    now = pwm.DoWork( late );
+    EXPECT_EQ( 1u, pwm.Overruns() );
+    EXPECT_EQ( late + m_config.UnitMs, now );
+}
+
+TEST_F( SoftPwmTest, CostsTheSameForAnyNumberOfPins )
+{
+    CallCosts costs = CallCosts::Uno();
+    m_state.SetCallCosts( &costs );
+
+    uint8_t levels[16];
+    for ( uint8_t i = 0; i < 16; i++ )
+    {
+        levels[i] = i * 17;
+    }
+
+    // The CPU time one second of `work` spends in DoWork() under a
+    // Scheduler
+    auto busy = [&]( ScheduledWork& work, size_t& calls ) {
+        ProfiledWork profiled( work, m_time );
+        SchedulerConfig config;
+        config.MaxSleepMs = 1000;
+        Scheduler scheduler( config );
+        scheduler.AddWork( profiled );
+
+        const unsigned long long start = m_time.NowNs();
+        m_time.SetDelayHook( [&]() {
+            if ( m_time.NowNs() - start >= 1000000000ULL )
+            {
+                scheduler.Stop();
+            }
+        });
+        scheduler.Loop();
+
+        calls = profiled.Calls();
+        return profiled.BusyNs();
+    };
+
+    m_config.NumPins = 1;
+    SoftPwm one( m_config );
+    one.Set( 0, 100 );
+    size_t oneCalls;
+    const unsigned long long oneNs = busy( one, oneCalls );
+
+    m_config.NumPins = 16;
+    SoftPwm sixteen( m_config );
+    for ( uint8_t i = 0; i < 16; i++ )
+    {
+        sixteen.Set( i, levels[i] );
+    }
+    size_t sixteenCalls;
+    const unsigned long long sixteenNs = busy( sixteen, sixteenCalls );
+
+    CounterPwm counter( m_pins, levels, 16 );
+    size_t counterCalls;
+    const unsigned long long counterNs = busy( counter, counterCalls );
+
+    // 4 cycles of 255ms, at 8 wake-ups a cycle rather than 255
+    EXPECT_EQ( 4u * 8, oneCalls );
+    EXPECT_EQ( oneCalls, sixteenCalls );
+    EXPECT_GT( counterCalls, 4u * 240 );
+
+    // Each wake-up is a masked write per port: one for 1 pin, and three
+    // for 16 pins over ports B, C and D. Only the SREG save, cli and
+    // restore are charged, as the shim can't see the write itself.
+    const unsigned long long writeNs = 3 * costs.InterruptsNs;
+    EXPECT_EQ( oneCalls * writeNs, oneNs );
+    EXPECT_EQ( sixteenCalls * 3 * writeNs, sixteenNs );
+    EXPECT_EQ( counterCalls * 16 * costs.DigitalWriteNs, counterNs );
+    EXPECT_LT( sixteenNs * 50, counterNs );
+}
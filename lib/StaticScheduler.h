@@ -0,0 +1,213 @@
+#ifndef Samduino_StaticScheduler_h
+#define Samduino_StaticScheduler_h
+
+/**
+ * The StaticScheduler is a compile-time alternative to the Scheduler
+ * for sketches whose set of work items is fixed. The tasks are stored
+ * by value inside the scheduler, so there is no heap allocation, no
+ * pointer chasing and no virtual dispatch; the due check and call for
+ * every task is unrolled and inlined into Loop().
+ *
+ * A task is any class with a method of the form
+ *
+ *      unsigned long DoWork( unsigned long now );
+ *
+ * following the same contract as ScheduledWork::DoWork(). It does not
+ * need to derive from ScheduledWork, though existing ScheduledWork
+ * classes such as SevenSegmentDisplayWork work as-is.
+ *
+ * Usage looks like:
+ *
+ *      samduino::StaticScheduler< samduino::SevenSegmentDisplayWork, ClockWork >
+ *          gScheduler( config, gSeven, gLayout.layout );
+ *
+ * where each argument after the config constructs the matching task.
+ */
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+
+#include "Arduino.h"
+#include "Scheduler.h"
+
+namespace samduino
+{
+
+namespace detail
+{
+
+// StaticTaskList holds each task by value along with its deadline,
+// recursing on the rest of the list. The empty list ends the recursion.
+template < typename... Tasks >
+class StaticTaskList;
+
+template <>
+class StaticTaskList<>
+{
+public:
+    void Run( unsigned long, unsigned long& ) {}
+};
+
+template < typename Task, typename... Rest >
+class StaticTaskList< Task, Rest... >
+{
+public:
+    StaticTaskList()
+        : m_dueAt( 0 )
+    {}
+
+    template < typename Arg, typename... RestArgs >
+    explicit StaticTaskList( Arg&& arg, RestArgs&&... rest )
+        : m_task( static_cast< Arg&& >( arg ) )
+        , m_dueAt( 0 )
+        , m_rest( static_cast< RestArgs&& >( rest )... )
+    {}
+
+    inline void Run( unsigned long now, unsigned long& wakeUpBy )
+    {
+        if ( now >= m_dueAt )
+        {
+            // Called on the object itself, so this binds statically
+            // even when Task's DoWork() is virtual.
+            m_dueAt = m_task.DoWork( now );
+        }
+
+        if ( m_dueAt < wakeUpBy )
+        {
+            wakeUpBy = m_dueAt;
+        }
+
+        m_rest.Run( now, wakeUpBy );
+    }
+
+    Task m_task;
+    unsigned long m_dueAt;
+    StaticTaskList< Rest... > m_rest;
+};
+
+// StaticTaskAt finds the I'th task in a StaticTaskList.
+template < uint8_t I, typename List >
+struct StaticTaskAt;
+
+template < typename Task, typename... Rest >
+struct StaticTaskAt< 0, StaticTaskList< Task, Rest... > >
+{
+    typedef Task Type;
+
+    static Type& Get( StaticTaskList< Task, Rest... >& list )
+    {
+        return list.m_task;
+    }
+};
+
+template < uint8_t I, typename Task, typename... Rest >
+struct StaticTaskAt< I, StaticTaskList< Task, Rest... > >
+{
+    typedef StaticTaskAt< I - 1, StaticTaskList< Rest... > > Next;
+    typedef typename Next::Type Type;
+
+    static Type& Get( StaticTaskList< Task, Rest... >& list )
+    {
+        return Next::Get( list.m_rest );
+    }
+};
+
+} // detail
+
+/**
+ * StaticScheduler runs a fixed list of tasks in the same way as
+ * Scheduler::Loop(): everything due is run against a single millis()
+ * snapshot and then it delay()'s until the next deadline or MaxSleepMs.
+ *
+ * Tasks run in the order they are listed and all are first due
+ * immediately.
+ */
+template < typename... Tasks >
+class StaticScheduler
+{
+public:
+    // Default-constructs every task.
+    explicit StaticScheduler( SchedulerConfig config )
+        : m_config( config )
+        , m_stopped( 0 )
+    {}
+
+    // Constructs each task from the matching argument.
+    template < typename... Args >
+    StaticScheduler( SchedulerConfig config, Args&&... args )
+        : m_config( config )
+        , m_stopped( 0 )
+        , m_tasks( static_cast< Args&& >( args )... )
+    {
+        static_assert( sizeof...( Args ) == sizeof...( Tasks ),
+                       "StaticScheduler needs one argument per task" );
+    }
+
+    StaticScheduler( const StaticScheduler& ) = delete;
+
+    // Task returns the I'th task.
+    template < uint8_t I >
+    typename detail::StaticTaskAt< I, detail::StaticTaskList< Tasks... > >::Type& Task()
+    {
+        return detail::StaticTaskAt< I, detail::StaticTaskList< Tasks... > >::Get( m_tasks );
+    }
+
+    // RunOnce behaves as Scheduler::RunOnce().
+    unsigned long RunOnce()
+    {
+        const unsigned long now = millis();
+
+        // Don't sleep longer than this
+        unsigned long wakeUpBy = now + m_config.MaxSleepMs;
+
+        m_tasks.Run( now, wakeUpBy );
+        return wakeUpBy < now ? now : wakeUpBy;
+    }
+
+    // RunUntil behaves as Scheduler::RunUntil().
+    unsigned long RunUntil( unsigned long deadline )
+    {
+        while ( true )
+        {
+            const unsigned long wakeUpBy = RunOnce();
+            const unsigned long after = millis();
+            if ( after < wakeUpBy || after >= deadline || m_stopped )
+            {
+                return wakeUpBy;
+            }
+        }
+    }
+
+    // Loop behaves as Scheduler::Loop().
+    void Loop()
+    {
+        while ( !m_stopped )
+        {
+            const unsigned long wakeUpBy = RunOnce();
+
+            const unsigned long after = millis();
+            if ( after < wakeUpBy )
+            {
+                delay( wakeUpBy - after );
+            }
+        }
+    }
+
+    // Stop behaves as Scheduler::Stop().
+    void Stop()
+    {
+        m_stopped = 1;
+    }
+
+private:
+    const SchedulerConfig m_config;
+    volatile uint8_t m_stopped;
+    detail::StaticTaskList< Tasks... > m_tasks;
+};
+
+} // samduino
+
+#endif // c++
+
+#endif
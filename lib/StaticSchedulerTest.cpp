@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include "ArduinoTestState.h"
+#include "SevenSegment.h"
+#include "StaticScheduler.h"
+
+using namespace samduino;
+
+namespace
+{
+
+// A task with no base class which runs every `period` milliseconds.
+class PeriodicTask
+{
+public:
+    explicit PeriodicTask( unsigned long period = 10 )
+        : m_period( period )
+        , m_count( 0 )
+        , m_last( 0 )
+    {}
+
+    size_t GetCount() const { return m_count; }
+    unsigned long GetLast() const { return m_last; }
+
+    unsigned long DoWork( unsigned long now )
+    {
+        m_count++;
+        m_last = now;
+        return now + m_period;
+    }
+
+private:
+    const unsigned long m_period;
+    size_t m_count;
+    unsigned long m_last;
+};
+
+}
+
+TEST( StaticSchedulerTest, RunsTasksOnTheirDeadlines )
+{
+    VirtualTimeProvider time;
+    ArduinoTestState state;
+    state.SetTimeProvider( &time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+
+    StaticScheduler< PeriodicTask, PeriodicTask, PeriodicTask > scheduler( config, 5, 20, 7 );
+
+    time.SetDelayHook( [&]() {
+        if ( millis() >= 100 )
+        {
+            scheduler.Stop();
+        }
+    });
+    scheduler.Loop();
+
+    EXPECT_EQ( 20, scheduler.Task< 0 >().GetCount() );
+    EXPECT_EQ( 95, scheduler.Task< 0 >().GetLast() );
+    EXPECT_EQ( 5, scheduler.Task< 1 >().GetCount() );
+    EXPECT_EQ( 15, scheduler.Task< 2 >().GetCount() );
+    EXPECT_EQ( 98, scheduler.Task< 2 >().GetLast() );
+}
+
+TEST( StaticSchedulerTest, DrivesSevenSegmentDisplayWork )
+{
+    VirtualTimeProvider time;
+    InMemoryInputOutputProvider io;
+    ArduinoTestState state;
+    state.SetTimeProvider( &time ).SetInputOutputProvider( &io );
+
+    uint8_t dPins[2] = { 10, 11 };
+    uint8_t dBits[2] = { SevenSegment::MakeBits( 1 ), SevenSegment::MakeBits( 0 ) };
+
+    SevenSegmentState layout;
+    layout.PinA = 2;
+    layout.PinB = 3;
+    layout.PinC = 4;
+    layout.PinD = 5;
+    layout.PinE = 6;
+    layout.PinF = 7;
+    layout.PinG = 8;
+    layout.PinDot = 9;
+    layout.NumD = 2;
+    layout.DPins = dPins;
+    layout.DBits = dBits;
+
+    SevenSegment seven( layout );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+
+    StaticScheduler< SevenSegmentDisplayWork > scheduler( config, seven );
+
+    // Stop after the first refresh, which selects digit 1 (a zero).
+    time.SetDelayHook( [&]() { scheduler.Stop(); } );
+    scheduler.Loop();
+
+    EXPECT_EQ( HIGH, io.ReadState( layout.PinA ).value );
+    EXPECT_EQ( LOW, io.ReadState( dPins[1] ).value );
+    EXPECT_EQ( HIGH, io.ReadState( dPins[0] ).value );
+    EXPECT_EQ( 5, millis() );
+}
+
+namespace
+{
+
+// A task with no base class which is always due and takes 1ms.
+class BusyTask
+{
+public:
+    explicit BusyTask( VirtualTimeProvider& time )
+        : m_time( time )
+        , m_count( 0 )
+    {}
+
+    size_t GetCount() const { return m_count; }
+
+    unsigned long DoWork( unsigned long )
+    {
+        m_count++;
+        m_time.Advance( 1000 );
+        return 0;
+    }
+
+private:
+    VirtualTimeProvider& m_time;
+    size_t m_count;
+};
+
+}
+
+TEST( StaticSchedulerTest, RunUntilBoundsAlwaysDueWork )
+{
+    VirtualTimeProvider time;
+    ArduinoTestState state;
+    state.SetTimeProvider( &time );
+
+    SchedulerConfig config;
+    config.MaxSleepMs = 1000;
+
+    StaticScheduler< BusyTask, PeriodicTask > scheduler( config, time, 50 );
+
+    // As with Scheduler, it runs until the deadline and says to come back
+    // right away.
+    EXPECT_EQ( 9, scheduler.RunUntil( 10 ) );
+    EXPECT_EQ( 10, scheduler.Task< 0 >().GetCount() );
+    EXPECT_EQ( 1, scheduler.Task< 1 >().GetCount() );
+    EXPECT_EQ( 10, millis() );
+
+    // With nothing due right away, it makes just the one pass.
+    StaticScheduler< PeriodicTask > idle( config, 50 );
+    EXPECT_EQ( 60, idle.RunUntil( 100 ) );
+    EXPECT_EQ( 1, idle.Task< 0 >().GetCount() );
+}
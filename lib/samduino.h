@@ -6,7 +6,19 @@
  * to include all things available in the `samduino` namespace.
  */
 
+#include "ButtonBank.h"
+#include "Crc8.h"
+#include "DS18B20.h"
+#include "HardwareTimer.h"
+#include "Keypad.h"
+#include "Max7219.h"
+#include "Observable.h"
+#include "OneWire.h"
+#include "RotaryEncoder.h"
 #include "Scheduler.h"
+#include "SettingsStore.h"
 #include "SevenSegment.h"
+#include "SoftPwm.h"
+#include "StaticScheduler.h"
 
 #endif
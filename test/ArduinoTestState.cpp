@@ -2,8 +2,13 @@
 
 #include <assert.h>
 #include <cstdint>
+#include <fcntl.h>
+#include <stdexcept>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
 
 namespace
 {
@@ -22,6 +27,16 @@ ArduinoTestState& AssertState()
     return *g_state;
 }
 
+// RaiseInterrupt runs a pin's interrupt through the TimeProvider, which
+// knows when interrupts can run.
+void RaiseInterrupt( void (*isr)( void ) )
+{
+    if ( isr )
+    {
+        AssertState().GetTimeProvider().RaiseInterrupt( isr );
+    }
+}
+
 }
 
 ////////////
@@ -54,11 +69,238 @@ void MonotonicTimeProvider::DelayMicroseconds( unsigned long us )
     std::this_thread::sleep_for( std::chrono::microseconds( us ) );
 }
 
+void MonotonicTimeProvider::AttachTimer( unsigned long, void (*)( void ) )
+{
+    throw std::logic_error( "Timer interrupts need a VirtualTimeProvider in test" );
+}
+
+void MonotonicTimeProvider::DetachTimer()
+{
+}
+
+////////////
+
+VirtualTimeProvider::VirtualTimeProvider()
+    : m_nowNs( 0 )
+    , m_chargedNs( 0 )
+    , m_timerIsr( nullptr )
+    , m_timerPeriodNs( 0 )
+    , m_timerNextNs( 0 )
+    , m_interruptNs( 0 )
+    , m_inIsr( false )
+    , m_masked( false )
+    , m_passing( 0 )
+    , m_timerFires( 0 )
+    , m_interrupts( 0 )
+{
+}
+
+void VirtualTimeProvider::Pend( void (*isr)( void ) )
+{
+    for ( auto pending : m_pending )
+    {
+        if ( pending == isr )
+        {
+            return;
+        }
+    }
+
+    m_pending.push_back( isr );
+}
+
+void VirtualTimeProvider::Pass( unsigned long long ns, bool busy )
+{
+    unsigned long long target = m_nowNs + ns;
+    m_passing++;
+
+    while ( true )
+    {
+        // Pending interrupts run as soon as they can
+        if ( !m_pending.empty() && !m_inIsr && !m_masked )
+        {
+            void (*isr)( void ) = m_pending.front();
+            m_pending.erase( m_pending.begin() );
+
+            const unsigned long long at = m_nowNs;
+            m_inIsr = true;
+            m_interrupts++;
+            if ( isr == m_timerIsr )
+            {
+                m_timerFires++;
+            }
+            Charge( m_interruptNs );
+            isr();
+            m_inIsr = false;
+
+            // reti sets SREG_I again, whatever the isr left it as
+            m_masked = false;
+
+            if ( busy )
+            {
+                target += m_nowNs - at;
+            }
+            continue;
+        }
+
+        const bool timerDue = m_timerIsr && m_timerNextNs <= target;
+        const bool eventDue = !m_events.empty() && m_events.begin()->first <= target;
+        if ( eventDue && ( !timerDue || m_events.begin()->first <= m_timerNextNs ) )
+        {
+            auto event = m_events.begin();
+            if ( m_nowNs < event->first )
+            {
+                m_nowNs = event->first;
+            }
+
+            std::function< void() > run = event->second;
+            m_events.erase( event );
+            run();
+        }
+        else if ( timerDue )
+        {
+            if ( m_nowNs < m_timerNextNs )
+            {
+                m_nowNs = m_timerNextNs;
+            }
+
+            m_timerNextNs += m_timerPeriodNs;
+            Pend( m_timerIsr );
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if ( m_nowNs < target )
+    {
+        m_nowNs = target;
+    }
+
+    m_passing--;
+}
+
+unsigned long VirtualTimeProvider::Millis()
+{
+    return static_cast< unsigned long >( m_nowNs / 1000000 );
+}
+
+unsigned long VirtualTimeProvider::Micros()
+{
+    return static_cast< unsigned long >( m_nowNs / 1000 );
+}
+
+void VirtualTimeProvider::Delay( unsigned long ms )
+{
+    Pass( static_cast< unsigned long long >( ms ) * 1000000, false );
+
+    if ( m_delayHook )
+    {
+        m_delayHook();
+    }
+}
+
+void VirtualTimeProvider::DelayMicroseconds( unsigned long us )
+{
+    // On AVR this is a loop of counted cycles rather than a wait on the
+    // clock, so time spent in interrupts makes it last longer.
+    Pass( static_cast< unsigned long long >( us ) * 1000, true );
+}
+
+void VirtualTimeProvider::Charge( unsigned long ns )
+{
+    m_chargedNs += ns;
+    Pass( ns, true );
+}
+
+void VirtualTimeProvider::AttachTimer( unsigned long periodUs, void (*isr)( void ) )
+{
+    if ( periodUs == 0 )
+    {
+        throw std::logic_error( "Timer period must not be 0" );
+    }
+
+    m_timerIsr = isr;
+    m_timerPeriodNs = static_cast< unsigned long long >( periodUs ) * 1000;
+    m_timerNextNs = m_nowNs + m_timerPeriodNs;
+}
+
+void VirtualTimeProvider::DetachTimer()
+{
+    for ( auto it = m_pending.begin(); it != m_pending.end(); ++it )
+    {
+        if ( *it == m_timerIsr )
+        {
+            m_pending.erase( it );
+            break;
+        }
+    }
+
+    m_timerIsr = nullptr;
+}
+
+void VirtualTimeProvider::EnableInterrupts( bool enabled )
+{
+    m_masked = !enabled;
+    if ( !m_masked && !m_passing )
+    {
+        Pass( 0, true );
+    }
+}
+
+void VirtualTimeProvider::RaiseInterrupt( void (*isr)( void ) )
+{
+    Pend( isr );
+
+    // Within a Pass() it is picked up by the loop.
+    if ( !m_passing )
+    {
+        Pass( 0, true );
+    }
+}
+
+void VirtualTimeProvider::Schedule( unsigned long long atNs, std::function< void() > event )
+{
+    m_events.emplace( atNs, event );
+}
+
+void VirtualTimeProvider::Advance( unsigned long us )
+{
+    Pass( static_cast< unsigned long long >( us ) * 1000, false );
+}
+
+////////////
+
+CallCosts CallCosts::Uno()
+{
+    // Rough figures for the stock core's digital/analog functions,
+    // which look up the port and timer for the pin on every call.
+    CallCosts costs;
+    costs.PinModeNs = 4000;
+    costs.DigitalWriteNs = 3500;
+    costs.DigitalReadNs = 3500;
+    costs.AnalogReadNs = 112000;
+    costs.MillisNs = 1500;
+    costs.MicrosNs = 3500;
+    costs.EepromReadNs = 1000;
+    costs.EepromWriteNs = 2000;
+
+    // 8 bits at the Uno's fastest SPI clock (8 MHz), plus the wait on
+    // SPIF and the loop around it.
+    costs.SpiTransferNs = 1500;
+
+    // Masking interrupts is a single cli or sei, as is each access to
+    // SREG.
+    costs.InterruptsNs = 63;
+    return costs;
+}
+
 ////////////
 
 InMemoryInputOutputProvider::PinState InMemoryInputOutputProvider::ReadState( uint8_t number )
 {
     std::lock_guard< std::mutex > lock( m_lock );
+    ApplyPortWrites();
 
     auto it = m_pins.find( number );
     if ( it == m_pins.end() )
@@ -70,33 +312,74 @@ InMemoryInputOutputProvider::PinState InMemoryInputOutputProvider::ReadState( ui
 }
 
 void InMemoryInputOutputProvider::WriteState( PinState state )
+{
+    void (*isr)( void ) = nullptr;
+    {
+        std::lock_guard< std::mutex > lock( m_lock );
+        ApplyPortWrites();
+        auto it = m_pins.find( state.number );
+        const uint8_t before = it == m_pins.end() ? state.value : it->second.value;
+        m_pins[ state.number ] = state;
+        UpdatePort( state );
+        isr = Changed( state, before );
+    }
+
+    // The isr will want to read the pins
+    RaiseInterrupt( isr );
+}
+
+void InMemoryInputOutputProvider::WriteAnalog( uint8_t pin, int value )
 {
     std::lock_guard< std::mutex > lock( m_lock );
-    m_pins[ state.number ] = state;
+    m_analog[ pin ] = value;
 }
 
-void InMemoryInputOutputProvider::PinMode( uint8_t pin, uint8_t mode )
+void InMemoryInputOutputProvider::AttachDevice( uint8_t pin, PinDevice* device )
 {
     std::lock_guard< std::mutex > lock( m_lock );
-    m_pins[ pin ] = PinState( pin, mode );
+    m_devices[ pin ] = device;
+    m_driving[ pin ] = false;
 }
 
-void InMemoryInputOutputProvider::DigitalWrite( uint8_t pin, uint8_t val )
+void InMemoryInputOutputProvider::PinMode( uint8_t pin, uint8_t mode )
 {
     std::lock_guard< std::mutex > lock( m_lock );
-    auto it = m_pins.find( pin );
-    if ( it == m_pins.end() )
+    ApplyPortWrites();
+    m_pins[ pin ] = PinState( pin, mode );
+    if ( mode == INPUT_PULLUP )
     {
-        throw std::logic_error( "Illegal pin " + std::to_string( pin ) + " specified in test" );
+        m_pins[ pin ].value = HIGH;
     }
+    UpdatePort( m_pins[ pin ] );
+    UpdateDevice( m_pins[ pin ] );
+}
 
-    PinState& state = it->second;
-    if ( state.mode != OUTPUT )
+void InMemoryInputOutputProvider::DigitalWrite( uint8_t pin, uint8_t val )
+{
+    void (*isr)( void ) = nullptr;
     {
-        throw std::logic_error( "Pin " + std::to_string( pin ) + " is not configured for output" );
+        std::lock_guard< std::mutex > lock( m_lock );
+        ApplyPortWrites();
+        auto it = m_pins.find( pin );
+        if ( it == m_pins.end() )
+        {
+            throw std::logic_error( "Illegal pin " + std::to_string( pin ) + " specified in test" );
+        }
+
+        PinState& state = it->second;
+        if ( state.mode != OUTPUT )
+        {
+            throw std::logic_error( "Pin " + std::to_string( pin ) + " is not configured for output" );
+        }
+
+        const uint8_t before = state.value;
+        state.value = val;
+        UpdatePort( state );
+        UpdateDevice( state );
+        isr = Changed( state, before );
     }
 
-    state.value = val;
+    RaiseInterrupt( isr );
 }
 
 int InMemoryInputOutputProvider::DigitalRead( uint8_t pin )
@@ -109,19 +392,350 @@ int InMemoryInputOutputProvider::DigitalRead( uint8_t pin )
     }
 
     PinState& state = it->second;
-    if ( state.mode != INPUT )
+    if ( state.mode != INPUT && state.mode != INPUT_PULLUP )
     {
         throw std::logic_error( "Pin " + std::to_string( pin ) + " is not configured for input" );
     }
 
+    auto device = m_devices.find( pin );
+    if ( device != m_devices.end() )
+    {
+        return device->second->PullsLow() ? LOW : HIGH;
+    }
+
     return it->second.value;
 }
 
+int InMemoryInputOutputProvider::AnalogRead( uint8_t pin )
+{
+    std::lock_guard< std::mutex > lock( m_lock );
+    auto it = m_analog.find( pin );
+    if ( it == m_analog.end() )
+    {
+        throw std::logic_error( "Analog pin " + std::to_string( pin ) + " has no value in test" );
+    }
+
+    return it->second;
+}
+
+uint8_t InMemoryInputOutputProvider::PinToPort( uint8_t pin )
+{
+    if ( pin < 8 )
+    {
+        return kPortD;
+    }
+    else if ( pin < 14 )
+    {
+        return kPortB;
+    }
+    else if ( pin < 20 )
+    {
+        return kPortC;
+    }
+
+    return NOT_A_PORT;
+}
+
+uint8_t InMemoryInputOutputProvider::PinToBitMask( uint8_t pin )
+{
+    if ( pin < 8 )
+    {
+        return 1 << pin;
+    }
+    else if ( pin < 14 )
+    {
+        return 1 << ( pin - 8 );
+    }
+    else if ( pin < 20 )
+    {
+        return 1 << ( pin - 14 );
+    }
+
+    return 0;
+}
+
+volatile uint8_t* InMemoryInputOutputProvider::PortInputRegister( uint8_t port )
+{
+    if ( port == NOT_A_PORT || port >= kNumPorts )
+    {
+        throw std::logic_error( "Illegal port " + std::to_string( port ) + " specified in test" );
+    }
+
+    return &m_portIn[ port ];
+}
+
+volatile uint8_t* InMemoryInputOutputProvider::PortOutputRegister( uint8_t port )
+{
+    if ( port == NOT_A_PORT || port >= kNumPorts )
+    {
+        throw std::logic_error( "Illegal port " + std::to_string( port ) + " specified in test" );
+    }
+
+    return &m_portOut[ port ];
+}
+
+void InMemoryInputOutputProvider::UpdatePort( const PinState& state )
+{
+    const uint8_t port = PinToPort( state.number );
+    if ( port == NOT_A_PORT )
+    {
+        return;
+    }
+
+    const uint8_t mask = PinToBitMask( state.number );
+    if ( state.value != LOW )
+    {
+        m_portIn[ port ] |= mask;
+    }
+    else
+    {
+        m_portIn[ port ] &= ~mask;
+    }
+
+    if ( state.mode == OUTPUT )
+    {
+        if ( state.value != LOW )
+        {
+            m_portOut[ port ] |= mask;
+        }
+        else
+        {
+            m_portOut[ port ] &= ~mask;
+        }
+
+        m_portOutSeen[ port ] = ( m_portOutSeen[ port ] & ~mask ) | ( m_portOut[ port ] & mask );
+    }
+}
+
+void InMemoryInputOutputProvider::ApplyPortWrites()
+{
+    // The first pin of each port
+    static const uint8_t kFirstPin[kNumPorts] = { 0, 0, 8, 14, 0 };
+
+    for ( uint8_t port = kPortB; port < kNumPorts; port++ )
+    {
+        const uint8_t written = m_portOut[ port ];
+        const uint8_t changed = written ^ m_portOutSeen[ port ];
+        m_portOutSeen[ port ] = written;
+
+        for ( uint8_t bit = 0; bit < 8; bit++ )
+        {
+            if ( !( changed & ( 1 << bit ) ) )
+            {
+                continue;
+            }
+
+            auto it = m_pins.find( kFirstPin[ port ] + bit );
+            if ( it == m_pins.end() || it->second.mode != OUTPUT )
+            {
+                continue;
+            }
+
+            it->second.value = ( written & ( 1 << bit ) ) ? HIGH : LOW;
+            UpdatePort( it->second );
+            UpdateDevice( it->second );
+        }
+    }
+}
+
+int InMemoryInputOutputProvider::PinToInterrupt( uint8_t pin )
+{
+    return pin;
+}
+
+void InMemoryInputOutputProvider::AttachInterrupt( uint8_t interruptNum, void (*isr)( void ), int mode )
+{
+    std::lock_guard< std::mutex > lock( m_lock );
+    m_interrupts[ interruptNum ] = Interrupt{ isr, mode };
+}
+
+void InMemoryInputOutputProvider::DetachInterrupt( uint8_t interruptNum )
+{
+    std::lock_guard< std::mutex > lock( m_lock );
+    m_interrupts.erase( interruptNum );
+}
+
+void (*InMemoryInputOutputProvider::Changed( const PinState& state, uint8_t before ))( void )
+{
+    auto it = m_interrupts.find( state.number );
+    if ( it == m_interrupts.end() )
+    {
+        return nullptr;
+    }
+
+    const bool wasHigh = before != LOW;
+    const bool isHigh = state.value != LOW;
+    if ( wasHigh == isHigh )
+    {
+        return nullptr;
+    }
+
+    const Interrupt& interrupt = it->second;
+    if ( interrupt.mode == CHANGE ||
+         ( interrupt.mode == RISING && isHigh ) ||
+         ( interrupt.mode == FALLING && !isHigh ) )
+    {
+        return interrupt.isr;
+    }
+
+    return nullptr;
+}
+
+void InMemoryInputOutputProvider::UpdateDevice( const PinState& state )
+{
+    auto device = m_devices.find( state.number );
+    if ( device == m_devices.end() )
+    {
+        return;
+    }
+
+    const bool low = state.mode == OUTPUT && state.value == LOW;
+    bool& driving = m_driving[ state.number ];
+    if ( low != driving )
+    {
+        driving = low;
+        device->second->Drive( low );
+    }
+}
+
+////////////
+
+FileEepromProvider::FileEepromProvider( const std::string& path, uint16_t size, TimeProvider& time )
+    : m_time( time )
+    , m_size( size )
+    , m_fd( -1 )
+    , m_data( nullptr )
+    , m_wear( size, 0 )
+    , m_writeUs( 3300 )
+    , m_busyUntilUs( 0 )
+    , m_busy( false )
+    , m_cutPower( false )
+    , m_writesLeft( 0 )
+    , m_writes( 0 )
+    , m_blockedUs( 0 )
+{
+    m_fd = ::open( path.c_str(), O_RDWR | O_CREAT, 0644 );
+    if ( m_fd < 0 )
+    {
+        throw std::runtime_error( "Unable to open eeprom file " + path );
+    }
+
+    struct stat st;
+    if ( ::fstat( m_fd, &st ) != 0 )
+    {
+        ::close( m_fd );
+        throw std::runtime_error( "Unable to stat eeprom file " + path );
+    }
+
+    // Grow a new or short file, filling the new space as erased
+    const off_t existing = st.st_size;
+    if ( existing < size )
+    {
+        std::vector< uint8_t > erased( size - existing, 0xFF );
+        if ( ::pwrite( m_fd, erased.data(), erased.size(), existing ) != static_cast< ssize_t >( erased.size() ) )
+        {
+            ::close( m_fd );
+            throw std::runtime_error( "Unable to size eeprom file " + path );
+        }
+    }
+
+    void* data = ::mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0 );
+    if ( data == MAP_FAILED )
+    {
+        ::close( m_fd );
+        throw std::runtime_error( "Unable to map eeprom file " + path );
+    }
+
+    m_data = static_cast< uint8_t* >( data );
+}
+
+FileEepromProvider::~FileEepromProvider()
+{
+    ::munmap( m_data, m_size );
+    ::close( m_fd );
+}
+
+void FileEepromProvider::WaitReady()
+{
+    if ( !IsReady() )
+    {
+        const unsigned long wait = m_busyUntilUs - m_time.Micros();
+        m_blockedUs += wait;
+        m_time.DelayMicroseconds( wait );
+        m_busy = false;
+    }
+}
+
+uint8_t FileEepromProvider::ReadByte( uint16_t address )
+{
+    if ( address >= m_size )
+    {
+        throw std::logic_error( "Illegal eeprom address " + std::to_string( address ) + " specified in test" );
+    }
+
+    WaitReady();
+    return m_data[ address ];
+}
+
+void FileEepromProvider::WriteByte( uint16_t address, uint8_t value )
+{
+    if ( address >= m_size )
+    {
+        throw std::logic_error( "Illegal eeprom address " + std::to_string( address ) + " specified in test" );
+    }
+
+    WaitReady();
+
+    if ( m_cutPower )
+    {
+        if ( m_writesLeft == 0 )
+        {
+            return;
+        }
+
+        m_writesLeft--;
+    }
+
+    m_data[ address ] = value;
+    m_wear[ address ]++;
+    m_writes++;
+
+    m_busy = true;
+    m_busyUntilUs = m_time.Micros() + m_writeUs;
+}
+
+bool FileEepromProvider::IsReady()
+{
+    if ( m_busy && m_time.Micros() >= m_busyUntilUs )
+    {
+        m_busy = false;
+    }
+
+    return !m_busy;
+}
+
+size_t FileEepromProvider::MaxWear() const
+{
+    size_t most = 0;
+    for ( size_t wear : m_wear )
+    {
+        if ( wear > most )
+        {
+            most = wear;
+        }
+    }
+
+    return most;
+}
+
 ////////////
 
 ArduinoTestState::ArduinoTestState()
     : m_time( nullptr )
     , m_io( nullptr )
+    , m_eeprom( nullptr )
+    , m_spi( nullptr )
+    , m_costs( nullptr )
 {
     assert( g_state == nullptr );
     g_state = this;
@@ -153,36 +767,234 @@ InputOutputProvider& ArduinoTestState::GetInputOutputProvider() const
     return *m_io;
 }
 
+EepromProvider& ArduinoTestState::GetEepromProvider() const
+{
+    if ( m_eeprom == nullptr )
+    {
+        throw std::logic_error( "EepromProvider not configured for this test" );
+    }
+
+    return *m_eeprom;
+}
+
+SpiProvider& ArduinoTestState::GetSpiProvider() const
+{
+    if ( m_spi == nullptr )
+    {
+        throw std::logic_error( "SpiProvider not configured for this test" );
+    }
+
+    return *m_spi;
+}
+
+void ArduinoTestState::Charge( unsigned long CallCosts::*cost )
+{
+    if ( m_costs && m_time )
+    {
+        m_time->Charge( m_costs->*cost );
+    }
+}
+
 ////////////
 // The global arduino functions
 ////////////
 
+SPIClass SPI;
+
+void SPIClass::begin()
+{
+}
+
+void SPIClass::end()
+{
+}
+
+void SPIClass::beginTransaction( SPISettings settings )
+{
+    return AssertState().GetSpiProvider().BeginTransaction( settings );
+}
+
+void SPIClass::endTransaction()
+{
+    return AssertState().GetSpiProvider().EndTransaction();
+}
+
+uint8_t SPIClass::transfer( uint8_t data )
+{
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::SpiTransferNs );
+    return state.GetSpiProvider().Transfer( data );
+}
+
+uint16_t SPIClass::transfer16( uint16_t data )
+{
+    // MSBFIRST, as the library assumes
+    const uint8_t high = transfer( static_cast< uint8_t >( data >> 8 ) );
+    const uint8_t low = transfer( static_cast< uint8_t >( data ) );
+    return static_cast< uint16_t >( ( high << 8 ) | low );
+}
+
+void SPIClass::transfer( void* buf, size_t count )
+{
+    uint8_t* bytes = static_cast< uint8_t* >( buf );
+    for ( size_t i = 0; i < count; i++ )
+    {
+        bytes[i] = transfer( bytes[i] );
+    }
+}
+
 extern "C"
 {
 
 void pinMode( uint8_t pin, uint8_t mode )
 {
-    return AssertState().GetInputOutputProvider().PinMode( pin, mode );
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::PinModeNs );
+    return state.GetInputOutputProvider().PinMode( pin, mode );
 }
 
 void digitalWrite( uint8_t pin, uint8_t val )
 {
-    return AssertState().GetInputOutputProvider().DigitalWrite( pin, val );
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::DigitalWriteNs );
+    return state.GetInputOutputProvider().DigitalWrite( pin, val );
 }
 
 int digitalRead( uint8_t pin )
 {
-    return AssertState().GetInputOutputProvider().DigitalRead( pin );
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::DigitalReadNs );
+    return state.GetInputOutputProvider().DigitalRead( pin );
+}
+
+int analogRead( uint8_t pin )
+{
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::AnalogReadNs );
+    return state.GetInputOutputProvider().AnalogRead( pin );
+}
+
+void shiftOut( uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val )
+{
+    // As the arduino core does it, so it is charged as the same
+    // 16 digitalWrite() calls.
+    for ( uint8_t i = 0; i < 8; i++ )
+    {
+        if ( bitOrder == LSBFIRST )
+        {
+            digitalWrite( dataPin, ( val & ( 1 << i ) ) ? HIGH : LOW );
+        }
+        else
+        {
+            digitalWrite( dataPin, ( val & ( 1 << ( 7 - i ) ) ) ? HIGH : LOW );
+        }
+
+        digitalWrite( clockPin, HIGH );
+        digitalWrite( clockPin, LOW );
+    }
+}
+
+uint8_t digitalPinToPort( uint8_t pin )
+{
+    return AssertState().GetInputOutputProvider().PinToPort( pin );
+}
+
+uint8_t digitalPinToBitMask( uint8_t pin )
+{
+    return AssertState().GetInputOutputProvider().PinToBitMask( pin );
+}
+
+volatile uint8_t* portInputRegister( uint8_t port )
+{
+    return AssertState().GetInputOutputProvider().PortInputRegister( port );
+}
+
+volatile uint8_t* portOutputRegister( uint8_t port )
+{
+    return AssertState().GetInputOutputProvider().PortOutputRegister( port );
+}
+
+uint8_t eeprom_read_byte( const uint8_t* address )
+{
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::EepromReadNs );
+    return state.GetEepromProvider().ReadByte( static_cast< uint16_t >( reinterpret_cast< uintptr_t >( address ) ) );
+}
+
+void eeprom_write_byte( uint8_t* address, uint8_t value )
+{
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::EepromWriteNs );
+    return state.GetEepromProvider().WriteByte( static_cast< uint16_t >( reinterpret_cast< uintptr_t >( address ) ), value );
+}
+
+int eeprom_is_ready( void )
+{
+    return AssertState().GetEepromProvider().IsReady() ? 1 : 0;
+}
+
+bool attachTimerInterrupt( unsigned long periodMicros, void (*isr)( void ) )
+{
+    AssertState().GetTimeProvider().AttachTimer( periodMicros, isr );
+    return true;
+}
+
+void detachTimerInterrupt( void )
+{
+    return AssertState().GetTimeProvider().DetachTimer();
+}
+
+int digitalPinToInterrupt( uint8_t pin )
+{
+    return AssertState().GetInputOutputProvider().PinToInterrupt( pin );
+}
+
+void attachInterrupt( uint8_t interruptNum, void (*isr)( void ), int mode )
+{
+    return AssertState().GetInputOutputProvider().AttachInterrupt( interruptNum, isr, mode );
+}
+
+void detachInterrupt( uint8_t interruptNum )
+{
+    return AssertState().GetInputOutputProvider().DetachInterrupt( interruptNum );
+}
+
+void noInterrupts( void )
+{
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::InterruptsNs );
+    return state.GetTimeProvider().EnableInterrupts( false );
+}
+
+void interrupts( void )
+{
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::InterruptsNs );
+    return state.GetTimeProvider().EnableInterrupts( true );
+}
+
+void cli( void )
+{
+    noInterrupts();
+}
+
+void sei( void )
+{
+    interrupts();
 }
 
 unsigned long millis()
 {
-    return AssertState().GetTimeProvider().Millis();
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::MillisNs );
+    return state.GetTimeProvider().Millis();
 }
 
 unsigned long micros()
 {
-    return AssertState().GetTimeProvider().Micros();
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::MicrosNs );
+    return state.GetTimeProvider().Micros();
 }
 
 void delay( unsigned long ms )
@@ -196,3 +1008,20 @@ void delayMicroseconds( unsigned long us )
 }
 
 }
+
+ArduinoStatusRegister SREG;
+
+ArduinoStatusRegister::operator uint8_t() const
+{
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::InterruptsNs );
+    return state.GetTimeProvider().InterruptsEnabled() ? 1 << SREG_I : 0;
+}
+
+ArduinoStatusRegister& ArduinoStatusRegister::operator=( uint8_t value )
+{
+    ArduinoTestState& state = AssertState();
+    state.Charge( &CallCosts::InterruptsNs );
+    state.GetTimeProvider().EnableInterrupts( value & ( 1 << SREG_I ) );
+    return *this;
+}
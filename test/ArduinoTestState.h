@@ -7,10 +7,15 @@
  */
 
 #include <chrono>
+#include <functional>
+#include <map>
 #include <mutex>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "Arduino.h"
+#include "SPI.h"
 
 /**
  * TimeProvider describes a test implementation of the time
@@ -25,6 +30,26 @@ public:
     virtual unsigned long Micros() = 0;
     virtual void Delay( unsigned long ) = 0;
     virtual void DelayMicroseconds( unsigned long ) = 0;
+
+    // Charge accounts for `ns` nanoseconds spent executing an emulated
+    // arduino call (see CallCosts). Providers that don't model time spent
+    // executing ignore it.
+    virtual void Charge( unsigned long ) {}
+
+    virtual void AttachTimer( unsigned long periodUs, void (*isr)( void ) ) = 0;
+    virtual void DetachTimer() = 0;
+
+    // EnableInterrupts implements interrupts() and noInterrupts().
+    // Providers without interrupts ignore it.
+    virtual void EnableInterrupts( bool ) {}
+
+    // InterruptsEnabled returns SREG_I: false while interrupts are
+    // disabled or one is running.
+    virtual bool InterruptsEnabled() { return true; }
+
+    // RaiseInterrupt is how other providers run an interrupt, such as on
+    // a pin change. Providers without interrupts just call it.
+    virtual void RaiseInterrupt( void (*isr)( void ) ) { isr(); }
 };
 
 /**
@@ -41,11 +66,145 @@ public:
     void Delay( unsigned long ) override;
     void DelayMicroseconds( unsigned long ) override;
 
+    // Timer interrupts aren't supported in real time.
+    void AttachTimer( unsigned long periodUs, void (*isr)( void ) ) override;
+    void DetachTimer() override;
+
 private:
     std::chrono::steady_clock m_clock;
     std::chrono::steady_clock::time_point m_start;
 };
 
+/**
+ * VirtualTimeProvider implements TimeProvider with a clock that only
+ * moves when delay()'d, charged or explicitly advanced. This makes timing
+ * in tests exact and independent of the host.
+ *
+ * An attached timer interrupt fires at exactly its period in virtual
+ * time, from within whatever call moves the clock past it. As on the
+ * board, interrupts don't nest, and time charged inside the interrupt
+ * holds up the code it interrupted. An interrupt raised while interrupts
+ * are disabled, or during another interrupt, is held pending and runs
+ * as soon as it can. Like the board's interrupt flags, raising one which
+ * is already pending does nothing, so it can be lost.
+ *
+ * Events outside the board (like a knob being turned) can be scheduled
+ * at exact times too. They run as the clock passes them, even during an
+ * interrupt or a busy-wait, and take no time themselves.
+ */
+class VirtualTimeProvider : public TimeProvider
+{
+public:
+    VirtualTimeProvider();
+
+    unsigned long Millis() override;
+    unsigned long Micros() override;
+    void Delay( unsigned long ) override;
+    void DelayMicroseconds( unsigned long ) override;
+    void Charge( unsigned long ns ) override;
+    void AttachTimer( unsigned long periodUs, void (*isr)( void ) ) override;
+    void DetachTimer() override;
+    void EnableInterrupts( bool enabled ) override;
+    bool InterruptsEnabled() override { return !m_masked && !m_inIsr; }
+    void RaiseInterrupt( void (*isr)( void ) ) override;
+
+    // Advance moves the clock forward without counting as a delay.
+    void Advance( unsigned long us );
+
+    // Schedule runs `event` once the clock reaches `atNs`.
+    void Schedule( unsigned long long atNs, std::function< void() > event );
+
+    // SetInterruptNs sets how long entering and leaving each interrupt
+    // takes, on top of whatever its isr charges.
+    void SetInterruptNs( unsigned long ns ) { m_interruptNs = ns; }
+
+    // TimerFires counts the timer interrupts run.
+    size_t TimerFires() const { return m_timerFires; }
+
+    // Interrupts counts all of the interrupts run.
+    size_t Interrupts() const { return m_interrupts; }
+
+    // NowNs reads the clock without being charged for it.
+    unsigned long long NowNs() const { return m_nowNs; }
+
+    // ChargedNs returns the total of all Charge()'d time.
+    unsigned long long ChargedNs() const { return m_chargedNs; }
+
+    // SetDelayHook installs a function called after every Delay(), which
+    // is the natural place for a test to Stop() a Scheduler.
+    void SetDelayHook( std::function< void() > hook )
+    {
+        m_delayHook = hook;
+    }
+
+private:
+    // Pass moves the clock forward `ns`, running any events and
+    // interrupts due along the way. When `busy`, the time is spent
+    // executing and so is pushed out by however long the interrupts take.
+    void Pass( unsigned long long ns, bool busy );
+
+    // Pend flags an interrupt as pending.
+    void Pend( void (*isr)( void ) );
+
+    unsigned long long m_nowNs;
+    unsigned long long m_chargedNs;
+    std::function< void() > m_delayHook;
+    std::multimap< unsigned long long, std::function< void() > > m_events;
+
+    void (*m_timerIsr)( void );
+    unsigned long long m_timerPeriodNs;
+    unsigned long long m_timerNextNs;
+    std::vector< void (*)( void ) > m_pending;
+    unsigned long m_interruptNs;
+    bool m_inIsr;
+    bool m_masked;
+    int m_passing;
+    size_t m_timerFires;
+    size_t m_interrupts;
+};
+
+/**
+ * CallCosts is a model of how long each emulated arduino call takes on
+ * the target. When set on the ArduinoTestState, every call charges its
+ * cost to the TimeProvider, so that a VirtualTimeProvider predicts how
+ * long code would take on the real board.
+ *
+ * All costs are in nanoseconds and default to 0.
+ */
+struct CallCosts
+{
+    unsigned long PinModeNs;
+    unsigned long DigitalWriteNs;
+    unsigned long DigitalReadNs;
+    unsigned long AnalogReadNs;
+    unsigned long MillisNs;
+    unsigned long MicrosNs;
+    unsigned long EepromReadNs;
+    unsigned long EepromWriteNs;
+    // Per byte, however it is transferred
+    unsigned long SpiTransferNs;
+    // Each of noInterrupts(), interrupts(), cli(), sei() and each read
+    // or write of SREG
+    unsigned long InterruptsNs;
+
+    CallCosts()
+        : PinModeNs( 0 )
+        , DigitalWriteNs( 0 )
+        , DigitalReadNs( 0 )
+        , AnalogReadNs( 0 )
+        , MillisNs( 0 )
+        , MicrosNs( 0 )
+        , EepromReadNs( 0 )
+        , EepromWriteNs( 0 )
+        , SpiTransferNs( 0 )
+        , InterruptsNs( 0 )
+    {}
+
+    // Uno returns approximate costs of the stock arduino core on a
+    // 16 MHz ATmega328P.
+    static CallCosts Uno();
+};
+
 /**
  * InputOutputProvider describes a test implementation of the i/o
  * functions in the arduino.
@@ -58,11 +217,50 @@ public:
     virtual void PinMode( uint8_t pin, uint8_t mode ) = 0;
     virtual void DigitalWrite( uint8_t pin, uint8_t val ) = 0;
     virtual int DigitalRead( uint8_t pin ) = 0;
+    virtual int AnalogRead( uint8_t pin ) = 0;
+
+    virtual uint8_t PinToPort( uint8_t pin ) = 0;
+    virtual uint8_t PinToBitMask( uint8_t pin ) = 0;
+    virtual volatile uint8_t* PortInputRegister( uint8_t port ) = 0;
+    virtual volatile uint8_t* PortOutputRegister( uint8_t port ) = 0;
+
+    virtual int PinToInterrupt( uint8_t pin ) = 0;
+    virtual void AttachInterrupt( uint8_t interruptNum, void (*isr)( void ), int mode ) = 0;
+    virtual void DetachInterrupt( uint8_t interruptNum ) = 0;
+};
+
+/**
+ * PinDevice describes an emulated device wired to a pin of the
+ * InMemoryInputOutputProvider, sharing an open-drain line with the board
+ * as a 1-Wire sensor does. The line is pulled up, so it reads LOW while
+ * either side pulls it low.
+ */
+class PinDevice
+{
+public:
+    virtual ~PinDevice() = default;
+
+    // Drive is called whenever the board starts (`low`) or stops pulling
+    // the line low, which it does by making the pin an OUTPUT written LOW.
+    virtual void Drive( bool low ) = 0;
+
+    // PullsLow returns true while the device is pulling the line low.
+    virtual bool PullsLow() = 0;
 };
 
 /**
  * InMemoryInputOutputProvider is an implemenrtation of InputOutputProvider
  * that allows for direct manipulation and checking of i/o state during testing.
+ *
+ * Pins 0-19 are also mapped onto emulated ports as on an Uno (0-7 on PORTD,
+ * 8-13 on PORTB and 14-19 on PORTC) whose input registers follow the pins.
+ * Writes to an output register are picked up by the OUTPUT pins of the
+ * port at the next call into the provider. They reach attached devices
+ * but don't raise interrupts. An INPUT_PULLUP pin starts out HIGH.
+ *
+ * Unlike the Uno, every pin can have an interrupt (numbered the same as
+ * the pin). It is raised through the TimeProvider whenever the pin's
+ * value changes as the mode asks, including from WriteState().
  */
 class InMemoryInputOutputProvider : public InputOutputProvider
 {
@@ -88,13 +286,149 @@ public:
     // of any pin.
     void WriteState( PinState );
 
+    // WriteAnalog sets the value analogRead() returns for a pin.
+    void WriteAnalog( uint8_t pin, int value );
+
+    // AttachDevice wires a device to a pin. digitalRead() of the pin then
+    // reads the line rather than the pin's value. The device is not owned
+    // and must outlive the provider's use.
+    void AttachDevice( uint8_t pin, PinDevice* device );
+
     virtual void PinMode( uint8_t pin, uint8_t mode ) override;
     virtual void DigitalWrite( uint8_t pin, uint8_t val ) override;
     virtual int DigitalRead( uint8_t pin ) override;
+    virtual int AnalogRead( uint8_t pin ) override;
+
+    virtual uint8_t PinToPort( uint8_t pin ) override;
+    virtual uint8_t PinToBitMask( uint8_t pin ) override;
+    virtual volatile uint8_t* PortInputRegister( uint8_t port ) override;
+    virtual volatile uint8_t* PortOutputRegister( uint8_t port ) override;
+
+    virtual int PinToInterrupt( uint8_t pin ) override;
+    virtual void AttachInterrupt( uint8_t interruptNum, void (*isr)( void ), int mode ) override;
+    virtual void DetachInterrupt( uint8_t interruptNum ) override;
+
+    // The emulated ports, numbered as in the AVR core.
+    enum
+    {
+        kPortB = 2,
+        kPortC = 3,
+        kPortD = 4,
+        kNumPorts = 5
+    };
 
 private:
+    // UpdatePort mirrors a pin's value into its port's input register,
+    // and its output register when it is an OUTPUT. m_lock must be held.
+    void UpdatePort( const PinState& );
+
+    // ApplyPortWrites brings the OUTPUT pins up to date with anything
+    // written straight to the output registers. m_lock must be held.
+    void ApplyPortWrites();
+
+    // Changed returns the interrupt to raise, if any, for a pin's value
+    // changing from `before`. m_lock must be held.
+    void (*Changed( const PinState&, uint8_t before ))( void );
+
+    // UpdateDevice tells any device on the pin when the board starts or
+    // stops pulling the line low. m_lock must be held.
+    void UpdateDevice( const PinState& );
+
     std::mutex m_lock;
     std::unordered_map< uint8_t, PinState > m_pins;
+    std::unordered_map< uint8_t, int > m_analog;
+    std::unordered_map< uint8_t, PinDevice* > m_devices;
+    std::unordered_map< uint8_t, bool > m_driving;
+
+    struct Interrupt
+    {
+        void (*isr)( void );
+        int mode;
+    };
+    std::unordered_map< uint8_t, Interrupt > m_interrupts;
+    volatile uint8_t m_portIn[kNumPorts] = {};
+    volatile uint8_t m_portOut[kNumPorts] = {};
+    // The output registers as of the last ApplyPortWrites()
+    uint8_t m_portOutSeen[kNumPorts] = {};
+};
+
+/**
+ * EepromProvider describes a test implementation of the eeprom
+ * functions in the arduino.
+ */
+class EepromProvider
+{
+public:
+    virtual ~EepromProvider() = default;
+
+    virtual uint8_t ReadByte( uint16_t address ) = 0;
+    virtual void WriteByte( uint16_t address, uint8_t value ) = 0;
+    virtual bool IsReady() = 0;
+};
+
+/**
+ * FileEepromProvider is an implementation of EepromProvider backed by a
+ * memory-mapped file, so its contents survive across "reboots" within a
+ * test (or across tests). A fresh file reads as erased (0xFF).
+ *
+ * Like the real device each write keeps it busy for a while, measured on
+ * the given TimeProvider. Accessing it while busy blocks on
+ * DelayMicroseconds() until the write completes.
+ */
+class FileEepromProvider : public EepromProvider
+{
+public:
+    FileEepromProvider( const std::string& path, uint16_t size, TimeProvider& time );
+    FileEepromProvider( const FileEepromProvider& ) = delete;
+    virtual ~FileEepromProvider();
+
+    uint8_t ReadByte( uint16_t address ) override;
+    void WriteByte( uint16_t address, uint8_t value ) override;
+    bool IsReady() override;
+
+    // SetWriteMicros sets how long a write keeps the device busy.
+    // It defaults to 3300us as on the ATmega328P.
+    void SetWriteMicros( unsigned long us ) { m_writeUs = us; }
+
+    // CutPowerAfter drops every write after the next `writes`, as if
+    // power was lost.
+    void CutPowerAfter( size_t writes ) { m_writesLeft = writes; m_cutPower = true; }
+
+    size_t Writes() const { return m_writes; }
+    size_t BlockedMicros() const { return m_blockedUs; }
+
+    // MaxWear returns the most writes any one address has seen.
+    size_t MaxWear() const;
+
+private:
+    void WaitReady();
+
+    TimeProvider& m_time;
+    uint16_t m_size;
+    int m_fd;
+    uint8_t* m_data;
+    std::vector< size_t > m_wear;
+    unsigned long m_writeUs;
+    unsigned long m_busyUntilUs;
+    bool m_busy;
+    bool m_cutPower;
+    size_t m_writesLeft;
+    size_t m_writes;
+    size_t m_blockedUs;
+};
+
+/**
+ * SpiProvider describes a test implementation of the SPI library, as
+ * seen by whatever device is on the bus.
+ */
+class SpiProvider
+{
+public:
+    virtual ~SpiProvider() = default;
+
+    virtual void BeginTransaction( const SPISettings& ) = 0;
+    virtual void EndTransaction() = 0;
+    virtual uint8_t Transfer( uint8_t ) = 0;
 };
 
 /**
@@ -126,9 +460,39 @@ public:
 
     InputOutputProvider& GetInputOutputProvider() const;
 
+    ArduinoTestState& SetEepromProvider( EepromProvider* eeprom )
+    {
+        m_eeprom = eeprom;
+        return *this;
+    }
+
+    EepromProvider& GetEepromProvider() const;
+
+    ArduinoTestState& SetSpiProvider( SpiProvider* spi )
+    {
+        m_spi = spi;
+        return *this;
+    }
+
+    SpiProvider& GetSpiProvider() const;
+
+    // SetCallCosts enables charging each arduino call to the TimeProvider.
+    // The costs are not copied and must outlive this state.
+    ArduinoTestState& SetCallCosts( const CallCosts* costs )
+    {
+        m_costs = costs;
+        return *this;
+    }
+
+    // Charge charges the given cost from the CallCosts, if any are set.
+    void Charge( unsigned long CallCosts::*cost );
+
 private:
     TimeProvider* m_time;
     InputOutputProvider* m_io;
+    EepromProvider* m_eeprom;
+    SpiProvider* m_spi;
+    const CallCosts* m_costs;
 };
 
 #endif
@@ -0,0 +1,99 @@
+#include "ChromeTrace.h"
+
+#include <cstdio>
+#include <sstream>
+
+#include "SchedulerTrace.h"
+
+namespace
+{
+
+uint32_t Get32( const uint8_t* data )
+{
+    return static_cast< uint32_t >( data[0] ) |
+        ( static_cast< uint32_t >( data[1] ) << 8 ) |
+        ( static_cast< uint32_t >( data[2] ) << 16 ) |
+        ( static_cast< uint32_t >( data[3] ) << 24 );
+}
+
+// Escape `text` for use inside a JSON string
+std::string Escape( const std::string& text )
+{
+    std::string escaped;
+    for ( char c : text )
+    {
+        if ( c == '"' || c == '\\' )
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if ( static_cast< unsigned char >( c ) < 0x20 )
+        {
+            char code[7];
+            snprintf( code, sizeof( code ), "\\u%04x", static_cast< unsigned >( c ) );
+            escaped += code;
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+}
+
+std::string DecodeChromeTrace( const uint8_t* dump, size_t size,
+                               const std::vector< std::string >& names )
+{
+    std::ostringstream out;
+    out << "{\"traceEvents\":[";
+
+    uint64_t wraps = 0;
+    uint32_t last = 0;
+    bool first = true;
+
+    for ( size_t offset = 0; offset + SAMDUINO_TRACE_RECORD_SIZE <= size; offset += SAMDUINO_TRACE_RECORD_SIZE )
+    {
+        const uint8_t id = dump[offset];
+        const uint32_t start = Get32( dump + offset + 1 );
+        const uint32_t duration = Get32( dump + offset + 5 );
+
+        // Records are in order, so going backwards means micros() wrapped
+        if ( !first && start < last )
+        {
+            wraps += 1ULL << 32;
+        }
+        last = start;
+
+        std::string name;
+        if ( id == SAMDUINO_TRACE_SLEEP )
+        {
+            name = "delay";
+        }
+        else if ( id < names.size() )
+        {
+            name = names[id];
+        }
+        else
+        {
+            name = "work " + std::to_string( id );
+        }
+
+        if ( !first )
+        {
+            out << ",";
+        }
+        first = false;
+
+        out << "{\"name\":\"" << Escape( name ) << "\""
+            << ",\"cat\":\"" << ( id == SAMDUINO_TRACE_SLEEP ? "sleep" : "work" ) << "\""
+            << ",\"ph\":\"X\""
+            << ",\"ts\":" << ( wraps + start )
+            << ",\"dur\":" << duration
+            << ",\"pid\":0,\"tid\":0}";
+    }
+
+    out << "]}";
+    return out.str();
+}
@@ -0,0 +1,22 @@
+#ifndef ChromeTrace_h
+#define ChromeTrace_h
+
+/**
+ * DecodeChromeTrace converts a dump of scheduler trace records (see
+ * SchedulerTrace.h) into the Chrome trace event JSON format, which can
+ * be loaded in Perfetto or chrome://tracing.
+ *
+ * Each DoWork() becomes a complete event named for its work id, or by
+ * `names[id]` when given, and each delay() one named "delay". Times
+ * wrapping past 32 bits of micros() are unwrapped.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+std::string DecodeChromeTrace( const uint8_t* dump, size_t size,
+                               const std::vector< std::string >& names = std::vector< std::string >() );
+
+#endif
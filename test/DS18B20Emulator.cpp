@@ -0,0 +1,191 @@
+#include "DS18B20Emulator.h"
+
+#include "Crc8.h"
+
+namespace
+{
+
+const unsigned long long kUs = 1000;
+
+// Pulses this long are a reset; shorter than kSampleNs are a 1.
+const unsigned long long kResetNs = 480 * kUs;
+const unsigned long long kSampleNs = 15 * kUs;
+
+// The presence pulse, timed from the end of the reset pulse
+const unsigned long long kPresenceWaitNs = 30 * kUs;
+const unsigned long long kPresenceNs = 120 * kUs;
+
+// How long a 0 is held from the start of a read slot
+const unsigned long long kZeroHoldNs = 30 * kUs;
+
+}
+
+DS18B20Emulator::DS18B20Emulator( const VirtualTimeProvider& time )
+    : m_time( time )
+    , m_connected( true )
+    , m_corrupt( false )
+    , m_rom{ 0x28, 0xFF, 0x64, 0x1E, 0x0F, 0x16, 0x03, 0 }
+    , m_scratchpad{ 0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0 }
+    , m_temperature( 0x0550 )
+    , m_conversionNs( 750000 * kUs )
+    , m_convertedAtNs( 0 )
+    , m_converting( false )
+    , m_conversions( 0 )
+    , m_resets( 0 )
+    , m_state( State::kIdle )
+    , m_byte( 0 )
+    , m_bits( 0 )
+    , m_sent( 0 )
+    , m_afterSend( State::kIdle )
+    , m_lowAtNs( 0 )
+    , m_holdFromNs( 0 )
+    , m_holdUntilNs( 0 )
+{
+    m_rom[7] = samduino::Crc8( m_rom, 7 );
+    m_scratchpad[8] = samduino::Crc8( m_scratchpad, 8 );
+}
+
+void DS18B20Emulator::Latch()
+{
+    if ( m_converting && m_time.NowNs() >= m_convertedAtNs )
+    {
+        m_converting = false;
+        m_scratchpad[0] = static_cast< uint8_t >( m_temperature );
+        m_scratchpad[1] = static_cast< uint8_t >( m_temperature >> 8 );
+        m_scratchpad[8] = samduino::Crc8( m_scratchpad, 8 );
+    }
+}
+
+uint8_t DS18B20Emulator::NextBit() const
+{
+    switch ( m_state )
+    {
+    case State::kSending:
+        return ( m_sending[m_sent / 8] >> ( m_sent % 8 ) ) & 1;
+
+    case State::kConverting:
+        // Read slots return 0 until the conversion is done
+        return m_converting ? 0 : 1;
+
+    default:
+        return 1;
+    }
+}
+
+void DS18B20Emulator::Drive( bool low )
+{
+    if ( !m_connected )
+    {
+        return;
+    }
+
+    const unsigned long long now = m_time.NowNs();
+    Latch();
+
+    if ( low )
+    {
+        m_lowAtNs = now;
+        if ( NextBit() == 0 )
+        {
+            m_holdFromNs = now;
+            m_holdUntilNs = now + kZeroHoldNs;
+        }
+
+        return;
+    }
+
+    const unsigned long long held = now - m_lowAtNs;
+    if ( held >= kResetNs )
+    {
+        m_resets++;
+        m_state = State::kRomCommand;
+        m_bits = 0;
+        m_holdFromNs = now + kPresenceWaitNs;
+        m_holdUntilNs = m_holdFromNs + kPresenceNs;
+        return;
+    }
+
+    switch ( m_state )
+    {
+    case State::kRomCommand:
+    case State::kFunctionCommand:
+        m_byte >>= 1;
+        if ( held < kSampleNs )
+        {
+            m_byte |= 0x80;
+        }
+
+        if ( ++m_bits == 8 )
+        {
+            m_bits = 0;
+            Received( m_byte );
+        }
+        break;
+
+    case State::kSending:
+        if ( ++m_sent == m_sending.size() * 8 )
+        {
+            m_state = m_afterSend;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool DS18B20Emulator::PullsLow()
+{
+    const unsigned long long now = m_time.NowNs();
+    return m_connected && now >= m_holdFromNs && now < m_holdUntilNs;
+}
+
+void DS18B20Emulator::Send( const uint8_t* data, size_t size, State after )
+{
+    m_sending.assign( data, data + size );
+    m_sent = 0;
+    m_afterSend = after;
+    m_state = State::kSending;
+}
+
+void DS18B20Emulator::Received( uint8_t byte )
+{
+    if ( m_state == State::kRomCommand )
+    {
+        if ( byte == 0xCC )
+        {
+            m_state = State::kFunctionCommand;
+        }
+        else if ( byte == 0x33 )
+        {
+            Send( m_rom, sizeof( m_rom ), State::kFunctionCommand );
+        }
+        else
+        {
+            m_state = State::kIdle;
+        }
+
+        return;
+    }
+
+    if ( byte == 0x44 )
+    {
+        m_conversions++;
+        m_converting = true;
+        m_convertedAtNs = m_time.NowNs() + m_conversionNs;
+        m_state = State::kConverting;
+    }
+    else if ( byte == 0xBE )
+    {
+        Send( m_scratchpad, sizeof( m_scratchpad ), State::kIdle );
+        if ( m_corrupt )
+        {
+            m_corrupt = false;
+            m_sending[0] ^= 0x01;
+        }
+    }
+    else
+    {
+        m_state = State::kIdle;
+    }
+}
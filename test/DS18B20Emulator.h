@@ -0,0 +1,87 @@
+#ifndef DS18B20Emulator_h
+#define DS18B20Emulator_h
+
+/**
+ * DS18B20Emulator is a bit-level emulation of a DS18B20 temperature
+ * sensor for the InMemoryInputOutputProvider. It decodes the board's
+ * 1-Wire slots purely from how long the line is held low, measured on a
+ * VirtualTimeProvider, and answers by pulling the line low itself, so
+ * it catches timing mistakes as the real sensor would.
+ *
+ * It supports Read ROM and Skip ROM, then Convert T and Read Scratchpad.
+ */
+
+#include <stdint.h>
+#include <vector>
+
+#include "ArduinoTestState.h"
+
+class DS18B20Emulator : public PinDevice
+{
+public:
+    explicit DS18B20Emulator( const VirtualTimeProvider& time );
+
+    // SetTemperature sets the temperature, in 1/16ths of a degree C, the
+    // next conversion will measure. The sensor powers up reading 85C.
+    void SetTemperature( int16_t raw ) { m_temperature = raw; }
+
+    // SetConnected connects or disconnects the sensor from the bus.
+    void SetConnected( bool connected ) { m_connected = connected; }
+
+    // CorruptNextScratchpad flips a bit of the next scratchpad sent.
+    void CorruptNextScratchpad() { m_corrupt = true; }
+
+    // SetConversionMicros sets how long a conversion takes.
+    void SetConversionMicros( unsigned long us ) { m_conversionNs = us * 1000ULL; }
+
+    const uint8_t* Rom() const { return m_rom; }
+    size_t Conversions() const { return m_conversions; }
+    size_t Resets() const { return m_resets; }
+
+    void Drive( bool low ) override;
+    bool PullsLow() override;
+
+private:
+    enum class State
+    {
+        kIdle,
+        kRomCommand,
+        kFunctionCommand,
+        kSending,
+        kConverting
+    };
+
+    void Received( uint8_t byte );
+    void Send( const uint8_t* data, size_t size, State after );
+    void Latch();
+    uint8_t NextBit() const;
+
+    const VirtualTimeProvider& m_time;
+    bool m_connected;
+    bool m_corrupt;
+
+    uint8_t m_rom[8];
+    uint8_t m_scratchpad[9];
+    int16_t m_temperature;
+    unsigned long long m_conversionNs;
+    unsigned long long m_convertedAtNs;
+    bool m_converting;
+    size_t m_conversions;
+    size_t m_resets;
+
+    State m_state;
+    uint8_t m_byte;
+    uint8_t m_bits;
+    std::vector< uint8_t > m_sending;
+    size_t m_sent;
+    State m_afterSend;
+
+    // When the board last pulled the line low
+    unsigned long long m_lowAtNs;
+
+    // The device holds the line low until this time
+    unsigned long long m_holdFromNs;
+    unsigned long long m_holdUntilNs;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include "EncoderSimulator.h"
+
+namespace
+{
+
+// Clockwise, AB goes 00, 01, 11, 10. A detent sits at 11.
+const uint8_t kGray[4] = { 0x3, 0x2, 0x0, 0x1 };
+
+}
+
+EncoderSimulator::EncoderSimulator( InMemoryInputOutputProvider& io, VirtualTimeProvider& time,
+                                    uint8_t pinA, uint8_t pinB )
+    : m_io( io )
+    , m_time( time )
+    , m_pinA( pinA )
+    , m_pinB( pinB )
+    , m_steps( 0 )
+    , m_doneNs( 0 )
+{
+    InMemoryInputOutputProvider::PinState a( m_pinA, INPUT );
+    a.value = HIGH;
+    m_io.WriteState( a );
+
+    InMemoryInputOutputProvider::PinState b( m_pinB, INPUT );
+    b.value = HIGH;
+    m_io.WriteState( b );
+}
+
+void EncoderSimulator::Step( int direction )
+{
+    const uint8_t before = kGray[m_steps & 3];
+    m_steps += direction;
+    const uint8_t after = kGray[m_steps & 3];
+
+    // Only one of the pins changes
+    const uint8_t pin = ( before ^ after ) & 0x2 ? m_pinA : m_pinB;
+    const uint8_t mask = pin == m_pinA ? 0x2 : 0x1;
+
+    InMemoryInputOutputProvider::PinState state = m_io.ReadState( pin );
+    state.value = ( after & mask ) ? HIGH : LOW;
+    m_io.WriteState( state );
+}
+
+void EncoderSimulator::Turn( long steps, unsigned long long stepNs )
+{
+    const int direction = steps < 0 ? -1 : 1;
+    unsigned long long at = m_doneNs > m_time.NowNs() ? m_doneNs : m_time.NowNs();
+
+    for ( long i = 0; i < steps * direction; i++ )
+    {
+        at += stepNs;
+        m_time.Schedule( at, [this, direction]() { Step( direction ); } );
+    }
+
+    m_doneNs = at;
+}
@@ -0,0 +1,52 @@
+#ifndef EncoderSimulator_h
+#define EncoderSimulator_h
+
+/**
+ * EncoderSimulator turns a quadrature encoder wired to two pins of an
+ * InMemoryInputOutputProvider. Each step is scheduled on the
+ * VirtualTimeProvider at its exact time, so steps keep coming while
+ * the board is busy or has interrupts disabled, just as a hand on the
+ * knob would.
+ */
+
+#include <stdint.h>
+
+#include "ArduinoTestState.h"
+
+class EncoderSimulator
+{
+public:
+    // The pins start as inputs at a detent (both HIGH).
+    EncoderSimulator( InMemoryInputOutputProvider& io, VirtualTimeProvider& time,
+                      uint8_t pinA, uint8_t pinB );
+
+    // Turn schedules `steps` steps (negative for counter-clockwise),
+    // `stepNs` apart, starting one step from now or after any turn
+    // already scheduled.
+    void Turn( long steps, unsigned long long stepNs );
+
+    // StepNsAt returns the step interval for turning at `rpm` with
+    // `stepsPerRev` steps per revolution.
+    static unsigned long long StepNsAt( unsigned long rpm, unsigned long stepsPerRev )
+    {
+        return 60000000000ULL / ( rpm * stepsPerRev );
+    }
+
+    // Steps returns where the knob actually is.
+    long Steps() const { return m_steps; }
+
+    // DoneNs returns when the scheduled turns end.
+    unsigned long long DoneNs() const { return m_doneNs; }
+
+private:
+    void Step( int direction );
+
+    InMemoryInputOutputProvider& m_io;
+    VirtualTimeProvider& m_time;
+    const uint8_t m_pinA;
+    const uint8_t m_pinB;
+    long m_steps;
+    unsigned long long m_doneNs;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "KeypadMatrix.h"
+
+KeypadMatrix::KeypadMatrix( InMemoryInputOutputProvider& io,
+                            const uint8_t* rowPins, uint8_t numRows,
+                            const uint8_t* colPins, uint8_t numCols )
+    : m_numRows( numRows )
+    , m_numCols( numCols )
+    , m_pressed( numRows * numCols, false )
+    , m_driven( numRows, false )
+{
+    for ( uint8_t i = 0; i < numRows; i++ )
+    {
+        m_lines.emplace_back( new Line( *this, true, i ) );
+        io.AttachDevice( rowPins[i], m_lines.back().get() );
+    }
+
+    for ( uint8_t i = 0; i < numCols; i++ )
+    {
+        m_lines.emplace_back( new Line( *this, false, i ) );
+        io.AttachDevice( colPins[i], m_lines.back().get() );
+    }
+}
+
+void KeypadMatrix::Press( uint8_t row, uint8_t col, bool pressed )
+{
+    m_pressed[ Key( row, col ) ] = pressed;
+}
+
+bool KeypadMatrix::Connected( uint8_t col ) const
+{
+    // Flood out from the column through the pressed keys
+    std::vector< bool > rows( m_numRows, false );
+    std::vector< bool > cols( m_numCols, false );
+    cols[ col ] = true;
+
+    bool grew = true;
+    while ( grew )
+    {
+        grew = false;
+        for ( uint8_t r = 0; r < m_numRows; r++ )
+        {
+            for ( uint8_t c = 0; c < m_numCols; c++ )
+            {
+                if ( m_pressed[ Key( r, c ) ] && rows[ r ] != cols[ c ] )
+                {
+                    rows[ r ] = cols[ c ] = true;
+                    grew = true;
+                }
+            }
+        }
+    }
+
+    for ( uint8_t r = 0; r < m_numRows; r++ )
+    {
+        if ( rows[ r ] && m_driven[ r ] )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void KeypadMatrix::Line::Drive( bool low )
+{
+    if ( m_isRow )
+    {
+        m_matrix.m_driven[ m_index ] = low;
+    }
+}
+
+bool KeypadMatrix::Line::PullsLow()
+{
+    return !m_isRow && m_matrix.Connected( m_index );
+}
@@ -0,0 +1,61 @@
+#ifndef KeypadMatrix_h
+#define KeypadMatrix_h
+
+/**
+ * KeypadMatrix wires a matrix of keys, without diodes, between row and
+ * column pins of an InMemoryInputOutputProvider. A column reads LOW
+ * when it connects to a row the board is driving LOW through any path
+ * of pressed keys, so three keys on the corners of a rectangle show a
+ * ghost at the fourth just as the real matrix does.
+ */
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "ArduinoTestState.h"
+
+class KeypadMatrix
+{
+public:
+    // Attaches to every row and column pin.
+    KeypadMatrix( InMemoryInputOutputProvider& io,
+                  const uint8_t* rowPins, uint8_t numRows,
+                  const uint8_t* colPins, uint8_t numCols );
+
+    void Press( uint8_t row, uint8_t col, bool pressed = true );
+    void Release( uint8_t row, uint8_t col ) { Press( row, col, false ); }
+
+    // Key returns the Keypad key number of row and col.
+    uint8_t Key( uint8_t row, uint8_t col ) const { return row * m_numCols + col; }
+
+private:
+    class Line : public PinDevice
+    {
+    public:
+        Line( KeypadMatrix& matrix, bool isRow, uint8_t index )
+            : m_matrix( matrix )
+            , m_isRow( isRow )
+            , m_index( index )
+        {}
+
+        void Drive( bool low ) override;
+        bool PullsLow() override;
+
+    private:
+        KeypadMatrix& m_matrix;
+        const bool m_isRow;
+        const uint8_t m_index;
+    };
+
+    // Connected returns true when `col` reaches a driven row.
+    bool Connected( uint8_t col ) const;
+
+    const uint8_t m_numRows;
+    const uint8_t m_numCols;
+    std::vector< bool > m_pressed;
+    std::vector< bool > m_driven;
+    std::vector< std::unique_ptr< Line > > m_lines;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "Max7219Emulator.h"
+
+#include <stdexcept>
+#include <string>
+
+Max7219Emulator::Max7219Emulator()
+    : m_registers{}
+    , m_shift( 0 )
+    , m_bits( 0 )
+    , m_inTransaction( false )
+    , m_frames( 0 )
+    , m_transactions( 0 )
+    , m_torn( 0 )
+{
+}
+
+uint8_t Max7219Emulator::Digit( uint8_t which ) const
+{
+    const uint8_t bits = m_registers[1 + which];
+    return static_cast< uint8_t >( ( bits << 1 ) | ( bits >> 7 ) );
+}
+
+void Max7219Emulator::Drive( bool low )
+{
+    if ( low )
+    {
+        m_bits = 0;
+        return;
+    }
+
+    // LOAD rising latches the shift register
+    if ( m_bits < 16 )
+    {
+        m_torn++;
+        return;
+    }
+
+    m_registers[( m_shift >> 8 ) & 0x0F] = static_cast< uint8_t >( m_shift );
+    m_frames++;
+}
+
+void Max7219Emulator::BeginTransaction( const SPISettings& settings )
+{
+    if ( m_inTransaction )
+    {
+        throw std::logic_error( "SPI transaction already begun" );
+    }
+
+    if ( settings.clock > 10000000 || settings.bitOrder != MSBFIRST || settings.dataMode != SPI_MODE0 )
+    {
+        throw std::logic_error( "MAX7219 needs MSBFIRST, SPI_MODE0 at up to 10 MHz, not " +
+                                std::to_string( settings.clock ) + " Hz" );
+    }
+
+    m_inTransaction = true;
+    m_transactions++;
+}
+
+void Max7219Emulator::EndTransaction()
+{
+    m_inTransaction = false;
+}
+
+uint8_t Max7219Emulator::Transfer( uint8_t data )
+{
+    if ( !m_inTransaction )
+    {
+        throw std::logic_error( "SPI transfer outside of a transaction" );
+    }
+
+    // DOUT is whatever is shifted out the other end
+    const uint8_t out = static_cast< uint8_t >( m_shift >> 8 );
+    m_shift = static_cast< uint16_t >( ( m_shift << 8 ) | data );
+    m_bits += 8;
+    return out;
+}
@@ -0,0 +1,55 @@
+#ifndef Max7219Emulator_h
+#define Max7219Emulator_h
+
+/**
+ * Max7219Emulator is a register-level emulation of a MAX7219 LED
+ * driver. It is the SpiProvider for the bus and is attached to the
+ * LOAD (CS) pin of an InMemoryInputOutputProvider as a PinDevice.
+ *
+ * As on the chip, every byte clocked in shifts through a 16-bit
+ * register, and the rising edge of LOAD latches its contents into the
+ * addressed register.
+ */
+
+#include <stdint.h>
+
+#include "ArduinoTestState.h"
+
+class Max7219Emulator : public PinDevice, public SpiProvider
+{
+public:
+    Max7219Emulator();
+
+    // Register returns the contents of a register (0x00 to 0x0F).
+    uint8_t Register( uint8_t reg ) const { return m_registers[reg & 0x0F]; }
+
+    // Digit returns what digit register `which` holds, remapped to
+    // SevenSegment's abcdefg. order.
+    uint8_t Digit( uint8_t which ) const;
+
+    // Frames counts the register writes latched, and Transactions the
+    // SPI transactions.
+    size_t Frames() const { return m_frames; }
+    size_t Transactions() const { return m_transactions; }
+
+    // Torn counts LOAD rising before 16 bits were shifted in.
+    size_t Torn() const { return m_torn; }
+
+    void Drive( bool low ) override;
+    bool PullsLow() override { return false; }
+
+    void BeginTransaction( const SPISettings& ) override;
+    void EndTransaction() override;
+    uint8_t Transfer( uint8_t ) override;
+
+private:
+    uint8_t m_registers[16];
+    uint16_t m_shift;
+    size_t m_bits;
+    bool m_inTransaction;
+    size_t m_frames;
+    size_t m_transactions;
+    size_t m_torn;
+};
+
+#endif
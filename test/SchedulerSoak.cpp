@@ -0,0 +1,446 @@
+#include "SchedulerSoak.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+#include "Arduino.h"
+
+using namespace samduino;
+
+namespace
+{
+
+const unsigned long long kNsPerMs = 1000000ULL;
+
+// How many breaches to describe
+const size_t kMaxErrors = 5;
+
+}
+
+/**
+ * Item is one work item of the workload. Each reports its dispatches
+ * to the soak so they can be checked against the model.
+ */
+class SchedulerSoak::Item : public ScheduledWork
+{
+public:
+    enum Kind
+    {
+        // Runs again a period after it ran
+        kPeriodic,
+        // Runs on a fixed grid, catching up when late
+        kFixedRate,
+        // Now and then asks to run again on the next pass
+        kPolling,
+        // Periodic, waking some bursty items each time
+        kProducer,
+        // Waits to be woken, then runs a few times in quick succession
+        kBursty
+    };
+
+    Item( SchedulerSoak& soak, size_t index, Kind kind, unsigned long periodMs,
+          unsigned long minCostUs, unsigned long maxCostUs )
+        : m_soak( soak )
+        , m_index( index )
+        , m_kind( kind )
+        , m_periodMs( periodMs )
+        , m_minCostUs( minCostUs )
+        , m_maxCostUs( maxCostUs )
+        , m_next( 0 )
+        , m_burst( 0 )
+        , m_parked( false )
+    {}
+
+    Kind GetKind() const { return m_kind; }
+    bool IsParked() const { return m_parked; }
+
+    // Park makes the next DoWork() return SCHEDULER_NEVER.
+    void Park() { m_parked = true; }
+    void Unpark()
+    {
+        m_parked = false;
+        m_next = 0;
+    }
+
+    unsigned long DoWork( unsigned long now ) override
+    {
+        m_soak.OnDispatch( m_index, now );
+        delayMicroseconds( m_soak.Uniform( m_minCostUs, m_maxCostUs ) );
+
+        unsigned long due = SCHEDULER_NEVER;
+        if ( m_parked )
+        {
+            // Nothing to do
+        }
+        else if ( m_kind == kPeriodic )
+        {
+            due = now + m_periodMs;
+        }
+        else if ( m_kind == kFixedRate )
+        {
+            m_next = ( m_next ? m_next : now ) + m_periodMs;
+            due = m_next;
+        }
+        else if ( m_kind == kPolling )
+        {
+            due = m_soak.Chance( 200 ) ? 0 : now + m_periodMs;
+        }
+        else if ( m_kind == kProducer )
+        {
+            const std::vector< size_t >& bursty = m_soak.m_bursty;
+            for ( unsigned long i = m_soak.Uniform( 1, 3 ); i && !bursty.empty(); i-- )
+            {
+                m_soak.WakeFrom( m_index, bursty[ m_soak.Uniform( 0, bursty.size() - 1 ) ] );
+            }
+            due = now + m_periodMs;
+        }
+        else
+        {
+            if ( m_burst == 0 )
+            {
+                m_burst = m_soak.Uniform( 1, 4 );
+            }
+
+            due = --m_burst ? now + 1 : SCHEDULER_NEVER;
+        }
+
+        m_soak.OnReturn( m_index, due );
+        return due;
+    }
+
+private:
+    SchedulerSoak& m_soak;
+    const size_t m_index;
+    const Kind m_kind;
+    const unsigned long m_periodMs;
+    const unsigned long m_minCostUs;
+    const unsigned long m_maxCostUs;
+    unsigned long m_next;
+    unsigned long m_burst;
+    bool m_parked;
+};
+
+SchedulerSoak::SchedulerSoak( const SoakConfig& config, VirtualTimeProvider& time, const CallCosts& costs )
+    : m_config( config )
+    , m_time( time )
+    , m_costs( costs )
+    , m_random( config.Seed )
+    , m_passNow( 0 )
+    , m_lastIndex( -1 )
+    , m_entryNs( 0 )
+    , m_busyNs( 0 )
+    , m_report()
+{}
+
+SchedulerSoak::~SchedulerSoak()
+{
+    // The scheduler refers to the items
+    m_scheduler.reset();
+}
+
+unsigned long SchedulerSoak::Uniform( unsigned long low, unsigned long high )
+{
+    return std::uniform_int_distribution< unsigned long >( low, high )( m_random );
+}
+
+bool SchedulerSoak::Chance( unsigned long perMille )
+{
+    return Uniform( 0, 999 ) < perMille;
+}
+
+void SchedulerSoak::Add( unsigned long now )
+{
+    const size_t index = m_items.size();
+
+    Item::Kind kind;
+    if ( Chance( m_config.BurstyPercent * 10 ) )
+    {
+        kind = Item::kBursty;
+    }
+    else
+    {
+        const unsigned long pick = Uniform( 0, 9 );
+        kind = pick < 1 ? Item::kProducer
+            : pick < 3 ? Item::kPolling
+            : pick < 6 ? Item::kFixedRate
+            : Item::kPeriodic;
+    }
+
+    const unsigned long periodMs = Uniform( m_config.MinPeriodMs, m_config.MaxPeriodMs );
+    const bool isLong = Chance( m_config.LongPercent * 10 );
+    if ( isLong )
+    {
+        m_report.LongItems++;
+    }
+    m_items.emplace_back( new Item( *this, index, kind, periodMs,
+                                    isLong ? m_config.LongCostUs / 2 : m_config.MinCostUs,
+                                    isLong ? m_config.LongCostUs : m_config.MaxCostUs ) );
+
+    // Bursty items wait to be woken, the rest start somewhere in their
+    // first period.
+    const unsigned long dueAt = kind == Item::kBursty
+        ? SCHEDULER_NEVER
+        : now + Uniform( 0, periodMs );
+
+    Model model;
+    model.item = m_items.back().get();
+    model.due = dueAt;
+    model.readyNs = dueAt * kNsPerMs;
+    model.periodMs = periodMs;
+    model.woken = false;
+    model.wokenBeforeTurn = false;
+    model.dispatched = false;
+    m_model.push_back( model );
+
+    if ( kind == Item::kBursty )
+    {
+        m_bursty.push_back( index );
+    }
+
+    m_scheduler->AddWork( *m_items.back(), dueAt );
+}
+
+bool SchedulerSoak::Churn( unsigned long now )
+{
+    if ( !Chance( m_config.ChurnPerMille ) )
+    {
+        return false;
+    }
+
+    const size_t index = Uniform( 0, m_items.size() - 1 );
+    Item& item = *m_items[ index ];
+
+    switch ( Uniform( 0, 2 ) )
+    {
+    case 0:
+        if ( m_items.size() < std::min< size_t >( m_config.MaxItems, 255 ) )
+        {
+            Add( now );
+            m_report.Adds++;
+            return true;
+        }
+        break;
+
+    case 1:
+        if ( item.GetKind() != Item::kBursty && !item.IsParked() )
+        {
+            item.Park();
+            m_report.Parks++;
+        }
+        break;
+
+    default:
+        // Only once it has actually gone to sleep
+        if ( item.IsParked() && m_model[ index ].due == SCHEDULER_NEVER )
+        {
+            item.Unpark();
+            m_scheduler->Wake( item );
+            Woken( index );
+            m_report.Wakes++;
+            return true;
+        }
+        break;
+    }
+
+    return false;
+}
+
+void SchedulerSoak::Violation( const std::string& error )
+{
+    m_report.Violations++;
+    if ( m_report.Errors.size() < kMaxErrors )
+    {
+        m_report.Errors.push_back( error );
+    }
+}
+
+void SchedulerSoak::OnDispatch( size_t index, unsigned long now )
+{
+    char error[128];
+    Model& model = m_model[ index ];
+
+    if ( now != m_passNow )
+    {
+        snprintf( error, sizeof( error ), "item %zu saw now %lu in the pass at %lu", index, now, m_passNow );
+        Violation( error );
+    }
+
+    if ( static_cast< long >( index ) <= m_lastIndex )
+    {
+        snprintf( error, sizeof( error ), "item %zu ran after item %ld at %lu", index, m_lastIndex, m_passNow );
+        Violation( error );
+    }
+    m_lastIndex = index;
+
+    if ( model.due > now && !model.woken )
+    {
+        snprintf( error, sizeof( error ), "item %zu ran at %lu but was due at %lu", index, now, model.due );
+        Violation( error );
+    }
+
+    m_entryNs = m_time.NowNs();
+    const unsigned long long late = m_entryNs > model.readyNs ? m_entryNs - model.readyNs : 0;
+    m_lateness.push_back( late );
+    if ( late >= model.periodMs * kNsPerMs )
+    {
+        m_report.Missed++;
+    }
+
+    model.woken = false;
+    model.dispatched = true;
+    m_report.Dispatches++;
+}
+
+void SchedulerSoak::OnReturn( size_t index, unsigned long due )
+{
+    const unsigned long long nowNs = m_time.NowNs();
+    m_busyNs += nowNs - m_entryNs;
+
+    Model& model = m_model[ index ];
+    model.due = due;
+    if ( !model.woken )
+    {
+        model.readyNs = std::max( static_cast< unsigned long long >( due ) * kNsPerMs, nowNs );
+    }
+}
+
+void SchedulerSoak::WakeFrom( size_t waker, size_t index )
+{
+    m_scheduler->Wake( *m_items[ index ] );
+    Woken( index );
+
+    if ( index > waker )
+    {
+        m_model[ index ].wokenBeforeTurn = true;
+    }
+}
+
+void SchedulerSoak::Woken( size_t index )
+{
+    // Ready now, unless it already was
+    Model& model = m_model[ index ];
+    if ( !model.woken )
+    {
+        model.woken = true;
+        model.readyNs = std::min( model.readyNs, m_time.NowNs() );
+    }
+}
+
+void SchedulerSoak::CheckPass( unsigned long passNow, unsigned long wakeUpBy,
+                               const std::vector< bool >& expected )
+{
+    char error[128];
+
+    // Exactly those due ran
+    for ( size_t i = 0; i < m_model.size(); i++ )
+    {
+        const bool shouldRun = expected[ i ] || m_model[ i ].wokenBeforeTurn;
+        if ( shouldRun != m_model[ i ].dispatched )
+        {
+            snprintf( error, sizeof( error ), "item %zu %s in the pass at %lu",
+                      i, shouldRun ? "didn't run" : "ran unexpectedly", passNow );
+            Violation( error );
+        }
+    }
+
+    // And the next pass is when the first of them is next due, or right
+    // away for any still woken
+    unsigned long next = passNow + m_config.MaxSleepMs;
+    bool woken = false;
+    for ( const Model& model : m_model )
+    {
+        next = std::min( next, model.due );
+        woken = woken || model.woken;
+    }
+
+    if ( woken || next < passNow )
+    {
+        next = passNow;
+    }
+
+    if ( next != wakeUpBy )
+    {
+        snprintf( error, sizeof( error ), "the pass at %lu asked for %lu rather than %lu",
+                  passNow, wakeUpBy, next );
+        Violation( error );
+    }
+}
+
+SoakReport SchedulerSoak::Run()
+{
+    SchedulerConfig config;
+    config.MaxSleepMs = m_config.MaxSleepMs;
+    m_scheduler.reset( new Scheduler( config ) );
+
+    const unsigned long long startNs = m_time.NowNs();
+    const unsigned long long endNs = startNs + m_config.DurationMs * kNsPerMs;
+
+    for ( uint16_t i = 0; i < m_config.NumItems; i++ )
+    {
+        Add( startNs / kNsPerMs );
+    }
+
+    std::vector< bool > expected;
+    while ( m_time.NowNs() < endNs )
+    {
+        // RunOnce() reads millis() once, which is charged before it reads.
+        const unsigned long passNow = ( m_time.NowNs() + m_costs.MillisNs ) / kNsPerMs;
+
+        expected.resize( m_model.size() );
+        for ( size_t i = 0; i < m_model.size(); i++ )
+        {
+            expected[ i ] = m_model[ i ].due <= passNow || m_model[ i ].woken;
+            m_model[ i ].wokenBeforeTurn = false;
+            m_model[ i ].dispatched = false;
+        }
+
+        m_passNow = passNow;
+        m_lastIndex = -1;
+
+        const unsigned long wakeUpBy = m_scheduler->RunOnce();
+        CheckPass( passNow, wakeUpBy, expected );
+        m_report.Passes++;
+
+        // Whatever was added or woken might be due before wakeUpBy, so an
+        // event loop must make another pass straight away.
+        if ( Churn( m_time.NowNs() / kNsPerMs ) )
+        {
+            continue;
+        }
+
+        // As Loop() does
+        const unsigned long after = millis();
+        if ( after < wakeUpBy )
+        {
+            delay( wakeUpBy - after );
+        }
+    }
+
+    if ( !m_lateness.empty() )
+    {
+        std::sort( m_lateness.begin(), m_lateness.end() );
+        m_report.P50Us = m_lateness[ m_lateness.size() / 2 ] / 1000;
+        m_report.P99Us = m_lateness[ m_lateness.size() * 99 / 100 ] / 1000;
+        m_report.MaxUs = m_lateness.back() / 1000;
+    }
+
+    m_report.Busy = static_cast< double >( m_busyNs ) / ( m_time.NowNs() - startNs );
+    return m_report;
+}
+
+std::string SoakReport::Header()
+{
+    return " seed items long% longs bursty% |  passes dispatch adds parks wakes |"
+        " p50us  p99us  maxus  missed busy% | breaches";
+}
+
+std::string SoakReport::Line( const SoakConfig& config ) const
+{
+    char line[160];
+    snprintf( line, sizeof( line ),
+              "%5u %5u %5u %5zu %7u | %7zu %8zu %4zu %5zu %5zu | %5llu %6llu %6llu %7zu %5.1f | %8zu",
+              config.Seed, config.NumItems, config.LongPercent, LongItems, config.BurstyPercent,
+              Passes, Dispatches, Adds, Parks, Wakes,
+              P50Us, P99Us, MaxUs, Missed, Busy * 100, Violations );
+    return line;
+}
@@ -0,0 +1,172 @@
+#ifndef SchedulerSoak_h
+#define SchedulerSoak_h
+
+/**
+ * SchedulerSoak runs a Scheduler against a seeded random workload in
+ * virtual time and checks every pass against a model of the scheduling
+ * contract:
+ *
+ *  - every item due at the start of a pass, or woken before its turn,
+ *    runs exactly once in that pass, in the order added, and nothing
+ *    else runs;
+ *  - every item in a pass sees the same `now`, read at its start;
+ *  - RunOnce() returns the start of the pass if anything woken hasn't
+ *    run since or is overdue, and otherwise the earliest deadline, but no
+ *    more than MaxSleepMs away.
+ *
+ * The workload mixes short and long, periodic, fixed-rate, polling and
+ * bursty items. Between passes items are added, parked (by returning
+ * SCHEDULER_NEVER) and woken again. The same seed always gives the same
+ * workload and the same report.
+ *
+ * Lateness is measured from when each item became due to when its
+ * DoWork() started. A dispatch a whole period or more late has missed
+ * its deadline.
+ */
+
+#include <stdint.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ArduinoTestState.h"
+#include "Scheduler.h"
+
+struct SoakConfig
+{
+    uint32_t Seed;
+
+    // Items to start with, and the most there can be once more are added
+    uint16_t NumItems;
+    uint16_t MaxItems;
+
+    // The range of periods, and of the cost of each DoWork()
+    unsigned long MinPeriodMs;
+    unsigned long MaxPeriodMs;
+    unsigned long MinCostUs;
+    unsigned long MaxCostUs;
+
+    // The percentage of items which take up to LongCostUs instead
+    uint8_t LongPercent;
+    unsigned long LongCostUs;
+
+    // The percentage of items which only run in bursts when woken
+    uint8_t BurstyPercent;
+
+    // The chance, per thousand passes, of adding, parking or waking
+    // an item
+    uint16_t ChurnPerMille;
+
+    unsigned long MaxSleepMs;
+    unsigned long DurationMs;
+
+    SoakConfig()
+        : Seed( 1 )
+        , NumItems( 16 )
+        , MaxItems( 32 )
+        , MinPeriodMs( 1 )
+        , MaxPeriodMs( 100 )
+        , MinCostUs( 5 )
+        , MaxCostUs( 100 )
+        , LongPercent( 0 )
+        , LongCostUs( 5000 )
+        , BurstyPercent( 20 )
+        , ChurnPerMille( 20 )
+        , MaxSleepMs( 50 )
+        , DurationMs( 10000 )
+    {}
+};
+
+struct SoakReport
+{
+    size_t Passes;
+    size_t Dispatches;
+    // Items made long, of all those added at the start or later
+    size_t LongItems;
+    size_t Adds;
+    size_t Parks;
+    size_t Wakes;
+
+    // Dispatches a whole period or more late
+    size_t Missed;
+
+    // Lateness of every dispatch
+    unsigned long long P50Us;
+    unsigned long long P99Us;
+    unsigned long long MaxUs;
+
+    // The fraction of the time spent running
+    double Busy;
+
+    // Breaches of the contract, and the first few described
+    size_t Violations;
+    std::vector< std::string > Errors;
+
+    // Line formats the report as a row of Header().
+    std::string Line( const SoakConfig& ) const;
+    static std::string Header();
+};
+
+class SchedulerSoak
+{
+public:
+    // The clock must be the ArduinoTestState's, charging `costs`.
+    SchedulerSoak( const SoakConfig& config, VirtualTimeProvider& time, const CallCosts& costs );
+    ~SchedulerSoak();
+
+    SoakReport Run();
+
+private:
+    class Item;
+
+    struct Model
+    {
+        Item* item;
+        unsigned long due;
+        // When it became due, for measuring lateness
+        unsigned long long readyNs;
+        unsigned long periodMs;
+        // Woken and not run since
+        bool woken;
+        bool wokenBeforeTurn;
+        bool dispatched;
+    };
+
+    void Add( unsigned long now );
+    // Churn returns true when it added or woke an item.
+    bool Churn( unsigned long now );
+    void CheckPass( unsigned long passNow, unsigned long wakeUpBy,
+                    const std::vector< bool >& expected );
+    void Violation( const std::string& );
+
+    // Called by the items
+    void OnDispatch( size_t index, unsigned long now );
+    void OnReturn( size_t index, unsigned long due );
+    void WakeFrom( size_t waker, size_t index );
+    void Woken( size_t index );
+
+    unsigned long Uniform( unsigned long low, unsigned long high );
+    bool Chance( unsigned long perMille );
+
+    const SoakConfig m_config;
+    VirtualTimeProvider& m_time;
+    const CallCosts& m_costs;
+    std::mt19937 m_random;
+
+    std::unique_ptr< samduino::Scheduler > m_scheduler;
+    std::vector< std::unique_ptr< Item > > m_items;
+    std::vector< Model > m_model;
+    std::vector< size_t > m_bursty;
+
+    // The pass in progress
+    unsigned long m_passNow;
+    long m_lastIndex;
+    unsigned long long m_entryNs;
+    unsigned long long m_busyNs;
+
+    std::vector< unsigned long long > m_lateness;
+    SoakReport m_report;
+};
+
+#endif
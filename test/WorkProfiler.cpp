@@ -0,0 +1,56 @@
+#include "WorkProfiler.h"
+
+ProfiledWork::ProfiledWork( samduino::ScheduledWork& work, const VirtualTimeProvider& time )
+    : m_work( work )
+    , m_time( time )
+    , m_calls( 0 )
+    , m_busyNs( 0 )
+    , m_maxNs( 0 )
+{
+}
+
+unsigned long ProfiledWork::DoWork( unsigned long now )
+{
+    const unsigned long long start = m_time.NowNs();
+    const unsigned long next = m_work.DoWork( now );
+    const unsigned long long took = m_time.NowNs() - start;
+
+    m_calls++;
+    m_busyNs += took;
+    if ( took > m_maxNs )
+    {
+        m_maxNs = took;
+    }
+
+    return next;
+}
+
+double ProfiledWork::AverageUs() const
+{
+    if ( m_calls == 0 )
+    {
+        return 0;
+    }
+
+    return m_busyNs / 1000.0 / m_calls;
+}
+
+double ProfiledWork::CallsPerSecond( unsigned long long elapsedNs ) const
+{
+    if ( elapsedNs == 0 )
+    {
+        return 0;
+    }
+
+    return m_calls * 1e9 / elapsedNs;
+}
+
+double ProfiledWork::Budget( unsigned long long elapsedNs ) const
+{
+    if ( elapsedNs == 0 )
+    {
+        return 0;
+    }
+
+    return static_cast< double >( m_busyNs ) / elapsedNs;
+}
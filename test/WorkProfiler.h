@@ -0,0 +1,47 @@
+#ifndef WorkProfiler_h
+#define WorkProfiler_h
+
+/**
+ * WorkProfiler helps predict on-target timing of ScheduledWork in tests.
+ * Combined with a CallCosts model and a VirtualTimeProvider, the virtual
+ * time spent inside each DoWork() is what the board would spend.
+ */
+
+#include <stddef.h>
+
+#include "ArduinoTestState.h"
+#include "Scheduler.h"
+
+/**
+ * ProfiledWork wraps another ScheduledWork, forwarding to it while
+ * measuring the virtual time spent in its DoWork().
+ */
+class ProfiledWork : public samduino::ScheduledWork
+{
+public:
+    ProfiledWork( samduino::ScheduledWork& work, const VirtualTimeProvider& time );
+
+    unsigned long DoWork( unsigned long now ) override;
+
+    size_t Calls() const { return m_calls; }
+    unsigned long long BusyNs() const { return m_busyNs; }
+    unsigned long long MaxNs() const { return m_maxNs; }
+
+    // AverageUs returns the mean time of one DoWork() in microseconds.
+    double AverageUs() const;
+
+    // CallsPerSecond returns how often the work ran over `elapsedNs`.
+    double CallsPerSecond( unsigned long long elapsedNs ) const;
+
+    // Budget returns the fraction of `elapsedNs` spent in this work.
+    double Budget( unsigned long long elapsedNs ) const;
+
+private:
+    samduino::ScheduledWork& m_work;
+    const VirtualTimeProvider& m_time;
+    size_t m_calls;
+    unsigned long long m_busyNs;
+    unsigned long long m_maxNs;
+};
+
+#endif
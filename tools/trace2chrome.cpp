@@ -0,0 +1,39 @@
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "ChromeTrace.h"
+
+/**
+ * trace2chrome converts a binary scheduler trace dump into Chrome trace
+ * JSON on stdout. Any names after the dump file label the work ids in
+ * order.
+ *
+ *      $ trace2chrome dump.bin display clock > trace.json
+ */
+int main( int argc, char** argv )
+{
+    if ( argc < 2 )
+    {
+        std::cerr << "usage: " << argv[0] << " <dump> [work names...]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in( argv[1], std::ios::binary );
+    if ( !in )
+    {
+        std::cerr << "unable to open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    const std::vector< uint8_t > dump(
+        ( std::istreambuf_iterator< char >( in ) ),
+        std::istreambuf_iterator< char >() );
+
+    const std::vector< std::string > names( argv + 2, argv + argc );
+
+    std::cout << DecodeChromeTrace( dump.data(), dump.size(), names ) << std::endl;
+    return 0;
+}